@@ -3,10 +3,12 @@
 //
 
 #include "board.h"
+#include "tt.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <limits.h>
 
 /*
  * This is used for the python link.
@@ -14,12 +16,23 @@
 unsigned int pboardsize = BOARD_SIZE;
 unsigned int ptilestacksize = TILE_STACK_SIZE;
 unsigned int pmaxturns = MAX_TURNS - 1;
+unsigned int pnplanes = N_PLANES;
+unsigned int pnsymmetries = N_SYMMETRIES;
 
 /*
  * Initialize the board.
  */
 struct board *init_board() {
-    struct board *board = calloc(1, sizeof(struct board));
+    struct board *board = malloc(sizeof(struct board));
+    reset_board(board);
+    return board;
+}
+
+/*
+ * Clears the board to the start of a game.
+ */
+void reset_board(struct board *board) {
+    memset(board, 0, sizeof(struct board));
     board->turn = 0;
     board->n_children = 0;
     board->n_stacked = 0;
@@ -38,49 +51,278 @@ struct board *init_board() {
     board->max_x = board->max_y = 0;
 
     board->zobrist_hash = 0;
+    board->zobrist_sum = 0;
 
     memset(&board->stack, -1, TILE_STACK_SIZE * sizeof(struct tile_stack));
 
     board->has_updated = 0;
 
-    return board;
+    memset(&board->tile_locations, -1, sizeof(board->tile_locations));
+    board->covered = 0;
 }
 
 
-void get_min_x_y(struct board *board, int *min_x, int *min_y) {
-    int lower_x = *min_x;
-    int lower_y = *min_y;
+#ifdef TORUS
+_Static_assert(BOARD_SIZE == 32, "The lines of the torus are tracked in 32-bit masks");
+
+/*
+ * Masks of the columns and rows which hold a tile.
+ */
+static void occupied_lines(struct board *board, uint32_t *columns, uint32_t *rows) {
+    *columns = *rows = 0;
+    for (int i = 0; i < N_TILES * 2; i++) {
+        int location = board->tile_locations[i];
+        if (location == -1) continue;
+
+        *columns |= 1u << (location % BOARD_SIZE);
+        *rows |= 1u << (location / BOARD_SIZE);
+    }
+}
+
+/*
+ * The hive is connected, so its lines form a single run around the torus. Returns the line which follows the empty
+ *  lines, or BOARD_SIZE if there is no tile.
+ */
+static int first_line(uint32_t occupied) {
+    uint32_t starts = occupied & ~((occupied << 1) | (occupied >> (BOARD_SIZE - 1)));
+    return starts == 0 ? BOARD_SIZE : __builtin_ctz(starts);
+}
+
+static int last_line(uint32_t occupied) {
+    uint32_t ends = occupied & ~((occupied >> 1) | (occupied << (BOARD_SIZE - 1)));
+    return ends == 0 ? 0 : __builtin_ctz(ends);
+}
+
+/*
+ * Computes where the hive starts on the torus, the lowest x and y if the hive does not cross the edge.
+ */
+void get_min_x_y(struct board *board, signed char *min_x, signed char *min_y) {
+    uint32_t columns, rows;
+    occupied_lines(board, &columns, &rows);
+    *min_x = first_line(columns);
+    *min_y = first_line(rows);
+}
+
+/*
+ * Computes where the hive ends, counting past the edge of the torus from the start of the hive.
+ */
+void get_max_x_y(struct board *board, signed char *max_x, signed char *max_y) {
+    uint32_t columns, rows;
+    occupied_lines(board, &columns, &rows);
+    int min_x = first_line(columns), min_y = first_line(rows);
+    *max_x = min_x + hive_offset(last_line(columns), min_x);
+    *max_y = min_y + hive_offset(last_line(rows), min_y);
+}
+
+/*
+ * Sets both the min and max of the board in a single pass over the tiles.
+ */
+void set_hive_bounds(struct board *board) {
+    uint32_t columns, rows;
+    occupied_lines(board, &columns, &rows);
+    board->min_x = first_line(columns);
+    board->min_y = first_line(rows);
+    board->max_x = board->min_x + hive_offset(last_line(columns), board->min_x);
+    board->max_y = board->min_y + hive_offset(last_line(rows), board->min_y);
+}
+#else
+
+/*
+ * Computes the lowest x and y coordinate of all tiles on the board using the tile locations.
+ */
+void get_min_x_y(struct board *board, signed char *min_x, signed char *min_y) {
     *min_x = *min_y = BOARD_SIZE;
-    for (int y = lower_y; y < BOARD_SIZE; y++) {
-        for (int x = lower_x; x < *min_x; x++) {
-            uchar tile = board->tiles[y * BOARD_SIZE + x];
-            if (tile == EMPTY) continue;
+    for (int i = 0; i < N_TILES * 2; i++) {
+        int location = board->tile_locations[i];
+        if (location == -1) continue;
 
-            // Set min_y to the first non-empty tile row
-            if (*min_y == BOARD_SIZE) *min_y = y;
+        *min_x = MIN(*min_x, location % BOARD_SIZE);
+        *min_y = MIN(*min_y, location / BOARD_SIZE);
+    }
+}
+
+/*
+ * Computes the highest x and y coordinate of all tiles on the board using the tile locations.
+ */
+void get_max_x_y(struct board *board, signed char *max_x, signed char *max_y) {
+    *max_x = *max_y = 0;
+    for (int i = 0; i < N_TILES * 2; i++) {
+        int location = board->tile_locations[i];
+        if (location == -1) continue;
+
+        *max_x = MAX(*max_x, location % BOARD_SIZE);
+        *max_y = MAX(*max_y, location / BOARD_SIZE);
+    }
+}
+#endif
+
+/*
+ * Location relative to the lowest x and y of the hive, and back. The offsets wrap around the board, so locations next
+ *  to the hive map back to themselves as well.
+ */
+int hive_relative_location(struct board *board, int location) {
+    return hive_offset(location / BOARD_SIZE, board->min_y) * BOARD_SIZE
+           + hive_offset(location % BOARD_SIZE, board->min_x);
+}
+
+int hive_absolute_location(struct board *board, int location) {
+    return ((location / BOARD_SIZE + board->min_y) % BOARD_SIZE) * BOARD_SIZE
+           + (location % BOARD_SIZE + board->min_x) % BOARD_SIZE;
+}
+
+/*
+ * Rebuilds the tile locations from the tiles and stack, for boards which were set up by hand.
+ */
+void index_tile_locations(struct board *board) {
+    memset(&board->tile_locations, -1, sizeof(board->tile_locations));
+    board->covered = 0;
 
-            if (x < *min_x) *min_x = x;
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++) {
+        if (board->tiles[i] == EMPTY) continue;
+        board->tile_locations[to_tile_index(board->tiles[i]) - 1] = i;
+    }
+    for (int i = 0; i < TILE_STACK_SIZE; i++) {
+        if (board->stack[i].location == -1) continue;
+
+        // Tiles which are on top of the stack are already indexed from the grid.
+        int location = board->stack[i].location;
+        if (board->tiles[location] == board->stack[i].type) continue;
+
+        int idx = to_tile_index(board->stack[i].type) - 1;
+        board->tile_locations[idx] = location;
+        board->covered |= 1u << idx;
+    }
+}
+
+
+/*
+ * Derives the tile locations, bounds, tiles left and queen positions from the tiles and stack of a board which was
+ *  set up directly instead of by playing moves.
+ */
+void set_board_information(struct board *board) {
+    index_tile_locations(board);
+
+    get_min_x_y(board, &board->min_x, &board->min_y);
+    get_max_x_y(board, &board->max_x, &board->max_y);
+
+    for (int i = 0; i < N_TILES * 2; i++) {
+        int location = board->tile_locations[i];
+        if (location == -1) continue;
+
+        uchar tile = from_tile_index(i + 1);
+        int type = tile & TILE_MASK;
+        int player = (tile & COLOR_MASK) >> COLOR_SHIFT;
+
+        if (type == L_GRASSHOPPER)
+            board->players[player].grasshoppers_left--;
+        if (type == L_ANT)
+            board->players[player].ants_left--;
+        if (type == L_BEETLE)
+            board->players[player].beetles_left--;
+        if (type == L_QUEEN) {
+            board->players[player].queens_left--;
+            if (player == 0)
+                board->light_queen_position = location;
+            else
+                board->dark_queen_position = location;
         }
+        if (type == L_SPIDER)
+            board->players[player].spiders_left--;
     }
 }
 
-void get_max_x_y(struct board *board, int *max_x, int *max_y) {
-    int upper_y = *max_y;
-    int upper_x = *max_x;
-    *max_x = *max_y = 0;
-    for (int y = upper_y; y >= 0; y--) {
-        for (int x = upper_x; x >= *max_x; x--) {
-            uchar tile = board->tiles[y * BOARD_SIZE + x];
-            if (tile == EMPTY) continue;
 
-            // Set min_y to the first non-empty tile row
-            if (*max_y == 0) *max_y = y;
+/*
+ * Adds (sign 1) or removes (sign -1) the tile at the location from the moments of its colour.
+ */
+void eval_track_tile(struct board *board, uchar tile, int location, int sign) {
+    struct eval_state *eval = &board->eval;
+    int color = (tile & COLOR_MASK) >> COLOR_SHIFT;
+#ifdef TORUS
+    // The grid wraps around, so the moments are taken relative to the start of the hive.
+    int x = hive_offset(location % BOARD_SIZE, board->min_x);
+    int y = hive_offset(location / BOARD_SIZE, board->min_y);
+#else
+    int x = location % BOARD_SIZE;
+    int y = location / BOARD_SIZE;
+#endif
+
+    eval->n_top[color] += sign;
+    eval->sum_x[color] += sign * x;
+    eval->sum_y[color] += sign * y;
+    eval->sum_squares[color] += sign * (x * x + y * y);
+}
+
+/*
+ * Moves the moments of both colours by (dx, dy), as if every tile on top was moved by it.
+ */
+void eval_translate(struct board *board, int dx, int dy) {
+    struct eval_state *eval = &board->eval;
+    for (int c = 0; c < 2; c++) {
+        eval->sum_squares[c] += 2 * (dx * eval->sum_x[c] + dy * eval->sum_y[c])
+                                + eval->n_top[c] * (dx * dx + dy * dy);
+        eval->sum_x[c] += eval->n_top[c] * dx;
+        eval->sum_y[c] += eval->n_top[c] * dy;
+    }
+}
+
+/*
+ * Returns whether two cells touch, using the neighbour layout of get_points_around.
+ */
+static bool cells_touch(int a, int b) {
+    int dx = wrap_delta(b % BOARD_SIZE - a % BOARD_SIZE);
+    int dy = wrap_delta(b / BOARD_SIZE - a / BOARD_SIZE);
+    if (dx < -1 || dx > 1 || dy < -1 || dy > 1) return false;
+    return (dx != 0 || dy != 0) && dx != -dy;
+}
 
-            if (x > *max_x) *max_x = x;
+/*
+ * Updates the queen neighbour counts after the tile at previous_location (or a new tile) was put on location.
+ * The tiles on the board have to be updated already.
+ */
+void eval_track_queens(struct board *board, int location, int previous_location, bool placed_on_empty) {
+    int queens[2] = {board->light_queen_position, board->dark_queen_position};
+    for (int c = 0; c < 2; c++) {
+        if (queens[c] == -1) continue;
+
+        // The queen moved, or a beetle climbed onto it.
+        if (queens[c] == location) {
+            board->eval.queen_neighbours[c] = count_tiles_around(board, location);
+            continue;
         }
+
+        if (previous_location != -1 && board->tiles[previous_location] == EMPTY
+            && cells_touch(queens[c], previous_location))
+            board->eval.queen_neighbours[c]--;
+        if (placed_on_empty && cells_touch(queens[c], location))
+            board->eval.queen_neighbours[c]++;
     }
 }
 
+/*
+ * Recomputes the tile moments and queen neighbour counts from scratch, for boards which are not built move by move.
+ * The mobility counters are left to full_update.
+ */
+void index_eval_state(struct board *board) {
+    struct eval_state *eval = &board->eval;
+    for (int c = 0; c < 2; c++) {
+        eval->n_top[c] = 0;
+        eval->sum_x[c] = eval->sum_y[c] = 0;
+        eval->sum_squares[c] = 0;
+    }
+
+    for (int i = 0; i < N_TILES * 2; i++) {
+        if (!tile_on_top(board, i)) continue;
+
+        int location = board->tile_locations[i];
+        eval_track_tile(board, board->tiles[location], location, 1);
+    }
+
+    eval->queen_neighbours[0] = board->light_queen_position == -1 ? 0
+            : count_tiles_around(board, board->light_queen_position);
+    eval->queen_neighbours[1] = board->dark_queen_position == -1 ? 0
+            : count_tiles_around(board, board->dark_queen_position);
+}
 
 void force_set_bounds(struct board *board) {
     board->min_y = board->min_x = board->max_x = board->max_y = -1;
@@ -138,6 +380,7 @@ void translate_board(struct board *board) {
 
     // Move all the tile tracking structs the same amount as the rest of the board.
     int translate_offset = (to_y * BOARD_SIZE + to_x) - offset;
+    zobrist_translate(board, offset, offset + translate_offset);
     if (board->light_queen_position != -1)
         board->light_queen_position += translate_offset;
     if (board->dark_queen_position != -1)
@@ -147,6 +390,11 @@ void translate_board(struct board *board) {
             board->stack[i].location += translate_offset;
         }
     }
+    for (int i = 0; i < N_TILES * 2; i++) {
+        if (board->tile_locations[i] != -1) {
+            board->tile_locations[i] += translate_offset;
+        }
+    }
 
     // Copy data into temp array
     char t[BOARD_SIZE * BOARD_SIZE] = {0};
@@ -168,6 +416,7 @@ void translate_board(struct board *board) {
     board->max_x += xdiff;
     board->min_y += ydiff;
     board->max_y += ydiff;
+    index_eval_state(board);
 }
 
 
@@ -194,6 +443,7 @@ void translate_board_22(struct board *board) {
 
     // Move all the tile tracking structs the same amount as the rest of the board.
     int translate_offset = (2 * BOARD_SIZE + 2) - offset;
+    zobrist_translate(board, offset, offset + translate_offset);
     if (board->light_queen_position != -1)
         board->light_queen_position += translate_offset;
     if (board->dark_queen_position != -1)
@@ -203,6 +453,11 @@ void translate_board_22(struct board *board) {
             board->stack[i].location += translate_offset;
         }
     }
+    for (int i = 0; i < N_TILES * 2; i++) {
+        if (board->tile_locations[i] != -1) {
+            board->tile_locations[i] += translate_offset;
+        }
+    }
 
     // Copy data into temp array
     char t[BOARD_SIZE * BOARD_SIZE] = {0};
@@ -216,6 +471,9 @@ void translate_board_22(struct board *board) {
     memset(&board->tiles, 0, BOARD_SIZE * BOARD_SIZE * sizeof(char));
     // Copy data back into main array after clearing data.
     memcpy(&board->tiles, temp, BOARD_SIZE * BOARD_SIZE * sizeof(char));
+    // The hash is relative to the lowest x and y, which are now known.
+    board->min_x = board->min_y = 2;
+    index_eval_state(board);
 }
 
 
@@ -276,13 +534,7 @@ int finished_board(struct board *board) {
         }
     }
 
-    // Check draw by repetition.
-//    int sum = 0;
-//    for (int i = 0; i < board->turn; i++) {
-//        if (board->hash_history[i] == board->zobrist_hash) sum++;
-//
-//        if (sum == 3) res = 3;
-//    }
+    // A draw by repetition depends on the game, not only the board, see struct hash_history.
 
     // Draw due to turn limit
     if (board->turn >= MAX_TURNS - 1) {
@@ -294,6 +546,357 @@ int finished_board(struct board *board) {
     return res;
 }
 
+/*
+ * Fills N_PLANES planes of BOARD_SIZE * BOARD_SIZE, plane i marks the location of the tile with to_tile_index i + 1
+ *  if it is on top. The last plane is filled with the player.
+ */
+void board_planes(struct board *board, int player, uchar *planes) {
+    memset(planes, 0, N_TILES * 2 * BOARD_SIZE * BOARD_SIZE);
+    for (int i = 0; i < N_TILES * 2; i++) {
+        if (tile_on_top(board, i))
+            planes[i * BOARD_SIZE * BOARD_SIZE + board->tile_locations[i]] = 1;
+    }
+    memset(&planes[N_TILES * 2 * BOARD_SIZE * BOARD_SIZE], player, BOARD_SIZE * BOARD_SIZE);
+}
+
+// The words of a packed position, a field crossing into the next word never writes past the last one.
+#define PACKED_WORDS 4
+_Static_assert(sizeof(struct packed_position) == PACKED_WORDS * sizeof(uint64_t), "Packed positions are 4 words");
+_Static_assert(PACKED_BEETLES_OFFSET + N_BEETLES * 2 * 3 <= PACKED_TURN_OFFSET
+               && PACKED_TURN_OFFSET + 16 <= PACKED_WORDS * 64, "The packed fields overlap or overflow");
+
+static void put_bits(uint64_t *bits, int offset, int n, uint64_t value) {
+    bits[offset / 64] |= value << (offset % 64);
+    if (offset % 64 + n > 64 && offset / 64 + 1 < PACKED_WORDS)
+        bits[offset / 64 + 1] |= value >> (64 - offset % 64);
+}
+
+static uint64_t get_bits(const uint64_t *bits, int offset, int n) {
+    uint64_t value = bits[offset / 64] >> (offset % 64);
+    if (offset % 64 + n > 64 && offset / 64 + 1 < PACKED_WORDS)
+        value |= bits[offset / 64 + 1] << (64 - offset % 64);
+    return value & ((1ull << n) - 1);
+}
+
+/*
+ * Index of the tile of the given beetle (0 to N_BEETLES * 2 - 1) in the tile locations.
+ */
+static int beetle_index(int beetle) {
+    int color = beetle / N_BEETLES;
+    int number = beetle % N_BEETLES + 1;
+    return to_tile_index((color << COLOR_SHIFT) | L_BEETLE | (number << NUMBER_SHIFT)) - 1;
+}
+
+/*
+ * Packs the board into a position of 32 bytes, see struct packed_position.
+ */
+void board_pack(struct board *board, struct packed_position *packed) {
+    memset(packed, 0, sizeof(struct packed_position));
+
+    signed char min_x, min_y;
+    get_min_x_y(board, &min_x, &min_y);
+    for (int i = 0; i < N_TILES * 2; i++) {
+        int location = board->tile_locations[i];
+        int field = PACKED_NOT_PLACED;
+        if (location != -1)
+            field = hive_offset(location % BOARD_SIZE, min_x) | hive_offset(location / BOARD_SIZE, min_y) << 5;
+        put_bits(packed->bits, i * 10, 10, field);
+    }
+
+    // Only beetles can be on top of other tiles, so they are the only tiles which are not on the ground.
+    for (int b = 0; b < N_BEETLES * 2; b++) {
+        int idx = beetle_index(b);
+        int location = board->tile_locations[idx];
+        if (location == -1) continue;
+
+        // Popping a tile from the stack can leave a gap, so all entries are checked.
+        int z = 0;
+        for (int i = 0; i < TILE_STACK_SIZE; i++) {
+            if (board->stack[i].location != location) continue;
+
+            if (board->covered & (1u << idx)) {
+                if (to_tile_index(board->stack[i].type) - 1 == idx) z = board->stack[i].z;
+            } else {
+                // The beetle on top is above all covered tiles.
+                z++;
+            }
+        }
+        put_bits(packed->bits, PACKED_BEETLES_OFFSET + b * 3, 3, z);
+    }
+    put_bits(packed->bits, PACKED_TURN_OFFSET, 16, board->turn);
+}
+
+/*
+ * Sets up the board from a packed position, with the hive centered as translate_board would.
+ */
+void board_unpack(struct board *board, struct packed_position *packed) {
+    reset_board(board);
+    board->turn = (int) get_bits(packed->bits, PACKED_TURN_OFFSET, 16);
+
+    int x[N_TILES * 2], y[N_TILES * 2], z[N_TILES * 2] = {0};
+    int width = 0, height = 0;
+    for (int i = 0; i < N_TILES * 2; i++) {
+        int field = (int) get_bits(packed->bits, i * 10, 10);
+        x[i] = field == PACKED_NOT_PLACED ? -1 : field & 31;
+        y[i] = field >> 5;
+        if (x[i] == -1) continue;
+
+        width = MAX(width, x[i] + 1);
+        height = MAX(height, y[i] + 1);
+    }
+    for (int b = 0; b < N_BEETLES * 2; b++) {
+        z[beetle_index(b)] = (int) get_bits(packed->bits, PACKED_BEETLES_OFFSET + b * 3, 3);
+    }
+
+    int to_x = (BOARD_SIZE / 2) - width / 2;
+    int to_y = (BOARD_SIZE / 2) - height / 2;
+    for (int i = 0; i < N_TILES * 2; i++) {
+        if (x[i] == -1) continue;
+
+        bool covered = false;
+        for (int j = 0; j < N_TILES * 2; j++) {
+            if (x[j] == x[i] && y[j] == y[i] && z[j] > z[i]) covered = true;
+        }
+
+        int location = (to_y + y[i]) * BOARD_SIZE + to_x + x[i];
+        uchar tile = from_tile_index(i + 1);
+        if (covered) {
+            struct tile_stack *ts = &board->stack[(int) board->n_stacked++];
+            ts->location = location;
+            ts->type = tile;
+            ts->z = z[i];
+        } else {
+            board->tiles[location] = tile;
+        }
+    }
+
+    set_board_information(board);
+    index_eval_state(board);
+    full_update(board);
+    hash_board(board);
+}
+
+/*
+ * Applies a symmetry of the hexagonal grid to an axial coordinate. The symmetries 0 to 5 rotate by 60 degrees that
+ *  many times, 6 to 11 first reflect along the x = y axis.
+ */
+static void symmetry_apply(int symmetry, int *x, int *y) {
+    if (symmetry >= 6) {
+        int t = *x;
+        *x = *y;
+        *y = t;
+    }
+    for (int i = 0; i < symmetry % 6; i++) {
+        int t = *x;
+        *x = *x - *y;
+        *y = t;
+    }
+}
+
+/*
+ * Reads the location of a tile relative to the lowest x and y of the hive.
+ * Returns false if the tile is not placed.
+ */
+bool packed_tile_location(struct packed_position *packed, int index, int *x, int *y) {
+    int field = (int) get_bits(packed->bits, index * 10, 10);
+    if (field == PACKED_NOT_PLACED) return false;
+
+    *x = field & 31;
+    *y = field >> 5;
+    return true;
+}
+
+/*
+ * Reads the height of a tile in its stack, 0 is on the ground. Only beetles can be higher.
+ */
+int packed_tile_height(struct packed_position *packed, int index) {
+    uchar tile = from_tile_index(index + 1);
+    if ((tile & TILE_MASK) != L_BEETLE) return 0;
+
+    int beetle = ((tile & COLOR_MASK) >> COLOR_SHIFT) * N_BEETLES + ((tile & NUMBER_MASK) >> NUMBER_SHIFT) - 1;
+    return (int) get_bits(packed->bits, PACKED_BEETLES_OFFSET + beetle * 3, 3);
+}
+
+/*
+ * Lowest x and y and the size of the hive after applying the symmetry.
+ */
+static void packed_extent(struct packed_position *packed, int symmetry, int *min_x, int *min_y, int *width,
+                          int *height) {
+    int max_x = INT_MIN, max_y = INT_MIN;
+    *min_x = *min_y = INT_MAX;
+    for (int i = 0; i < N_TILES * 2; i++) {
+        int x, y;
+        if (!packed_tile_location(packed, i, &x, &y)) continue;
+
+        symmetry_apply(symmetry, &x, &y);
+        *min_x = MIN(*min_x, x);
+        *min_y = MIN(*min_y, y);
+        max_x = MAX(max_x, x);
+        max_y = MAX(max_y, y);
+    }
+    if (max_x == INT_MIN) {
+        *min_x = *min_y = *width = *height = 0;
+        return;
+    }
+    *width = max_x - *min_x + 1;
+    *height = max_y - *min_y + 1;
+}
+
+/*
+ * Applies one of the N_SYMMETRIES symmetries to a packed position, symmetry 0 leaves it as it is.
+ * Hive plays the same in all of them, so they can share evaluations and training data.
+ */
+void packed_transform(struct packed_position *packed, int symmetry, struct packed_position *transformed) {
+    int min_x, min_y, width, height;
+    packed_extent(packed, symmetry, &min_x, &min_y, &width, &height);
+
+    struct packed_position result = {0};
+    for (int i = 0; i < N_TILES * 2; i++) {
+        int x, y, field = PACKED_NOT_PLACED;
+        if (packed_tile_location(packed, i, &x, &y)) {
+            symmetry_apply(symmetry, &x, &y);
+            field = (x - min_x) | (y - min_y) << 5;
+        }
+        put_bits(result.bits, i * 10, 10, field);
+    }
+    // The beetle heights and the turn do not change.
+    int n_rest = 256 - PACKED_BEETLES_OFFSET;
+    put_bits(result.bits, PACKED_BEETLES_OFFSET, n_rest, get_bits(packed->bits, PACKED_BEETLES_OFFSET, n_rest));
+    *transformed = result;
+}
+
+/*
+ * Maps a location on the board unpacked from the packed position to the same cell on the board unpacked from the
+ *  position transformed by the symmetry. This also maps the locations of moves, which can lie next to the hive.
+ * Returns -1 if the cell falls off the board.
+ */
+int packed_transform_location(struct packed_position *packed, int symmetry, int location) {
+    int min_x, min_y, width, height;
+    packed_extent(packed, 0, &min_x, &min_y, &width, &height);
+    int x = location % BOARD_SIZE - (BOARD_SIZE / 2 - width / 2);
+    int y = location / BOARD_SIZE - (BOARD_SIZE / 2 - height / 2);
+
+    packed_extent(packed, symmetry, &min_x, &min_y, &width, &height);
+    symmetry_apply(symmetry, &x, &y);
+    x += BOARD_SIZE / 2 - width / 2 - min_x;
+    y += BOARD_SIZE / 2 - height / 2 - min_y;
+
+    if (x < 0 || x >= BOARD_SIZE || y < 0 || y >= BOARD_SIZE) return -1;
+    return y * BOARD_SIZE + x;
+}
+
+static int packed_compare(struct packed_position *a, struct packed_position *b) {
+    for (int i = 0; i < 4; i++) {
+        if (a->bits[i] != b->bits[i]) return a->bits[i] < b->bits[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+/*
+ * Tiles of the same type and colour can trade places without changing the position, so they are put in the order of
+ *  their locations. The beetles take their heights along.
+ */
+static void packed_sort_tiles(struct packed_position *packed) {
+    int fields[N_TILES * 2], heights[N_TILES * 2] = {0};
+    for (int i = 0; i < N_TILES * 2; i++) {
+        fields[i] = (int) get_bits(packed->bits, i * 10, 10);
+    }
+    for (int b = 0; b < N_BEETLES * 2; b++) {
+        heights[beetle_index(b)] = (int) get_bits(packed->bits, PACKED_BEETLES_OFFSET + b * 3, 3);
+    }
+
+    // An insertion sort within every run of tiles of the same kind, those have consecutive indices.
+    for (int i = 1; i < N_TILES * 2; i++) {
+        for (int j = i; j > 0; j--) {
+            bool same_kind = (from_tile_index(j) & ~NUMBER_MASK) == (from_tile_index(j + 1) & ~NUMBER_MASK);
+            if (!same_kind || fields[j - 1] < fields[j] || (fields[j - 1] == fields[j] && heights[j - 1] <= heights[j]))
+                break;
+
+            int t = fields[j];
+            fields[j] = fields[j - 1];
+            fields[j - 1] = t;
+            t = heights[j];
+            heights[j] = heights[j - 1];
+            heights[j - 1] = t;
+        }
+    }
+
+    uint64_t turn = get_bits(packed->bits, PACKED_TURN_OFFSET, 16);
+    memset(packed, 0, sizeof(struct packed_position));
+    for (int i = 0; i < N_TILES * 2; i++) {
+        put_bits(packed->bits, i * 10, 10, fields[i]);
+    }
+    for (int b = 0; b < N_BEETLES * 2; b++) {
+        put_bits(packed->bits, PACKED_BEETLES_OFFSET + b * 3, 3, heights[beetle_index(b)]);
+    }
+    put_bits(packed->bits, PACKED_TURN_OFFSET, 16, turn);
+}
+
+/*
+ * Packs the board in its canonical form, the smallest packed position of all its symmetries. Positions which are the
+ *  same up to translation, rotation, reflection and swapping tiles of the same type have the same canonical form.
+ * Returns the symmetry which gives the canonical form.
+ */
+int board_canonical(struct board *board, struct packed_position *canonical) {
+    struct packed_position packed, transformed;
+    board_pack(board, &packed);
+
+    int best = 0;
+    for (int symmetry = 0; symmetry < N_SYMMETRIES; symmetry++) {
+        packed_transform(&packed, symmetry, &transformed);
+        packed_sort_tiles(&transformed);
+        if (symmetry == 0 || packed_compare(&transformed, canonical) < 0) {
+            *canonical = transformed;
+            best = symmetry;
+        }
+    }
+    return best;
+}
+
+/*
+ * Starts the history of a search from the history of the game, or from the root alone if the game is not known.
+ */
+void history_start(struct hash_history *history, struct hash_history *game, struct board *root) {
+    if (game != NULL) {
+        *history = *game;
+    } else {
+        history->first = root->turn;
+    }
+    history_push(history, root);
+}
+
+/*
+ * Pushes the hash of the board on the history of the game, and pops it again.
+ */
+void history_push(struct hash_history *history, struct board *board) {
+    int n_left = 0;
+    for (int i = 0; i < 2; i++) {
+        struct player *p = &board->players[i];
+        n_left += p->ants_left + p->grasshoppers_left + p->beetles_left + p->spiders_left + p->queens_left;
+    }
+
+    history->hashes[board->turn] = board->zobrist_hash;
+    history->n_placed[board->turn] = N_TILES * 2 - n_left;
+    history->n = board->turn + 1;
+}
+
+void history_pop(struct hash_history *history) {
+    history->n--;
+}
+
+/*
+ * Returns how often the last position of the history occurred before with the same player to move. Only the moves
+ *  since the last placement can lead back to it, so the scan stops there.
+ */
+int history_repetitions(struct hash_history *history) {
+    int last = history->n - 1;
+    int count = 0;
+    for (int i = last - 2; i >= history->first && history->n_placed[i] == history->n_placed[last]; i -= 2) {
+        if (history->hashes[i] == history->hashes[last]) count++;
+    }
+    return count;
+}
+
 /*
  * Prints the given Hive board to standard output.
  * Mainly for testing purposes
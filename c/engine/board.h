@@ -6,6 +6,8 @@
 #define THEHIVE_BOARD_H
 
 // Amount of tiles available per player.
+#include <stddef.h>
+#include <stdint.h>
 #include "list.h"
 #include "moves.h"
 #include "utils.h"
@@ -62,7 +64,7 @@
 #pragma pack(1)
 struct tile_stack {
     unsigned char type;
-    int location;
+    short location;
     unsigned char z;
 };
 
@@ -86,47 +88,157 @@ struct player {
 
 // Add a padding around the board to simplify edge conditions
 #define BOARD_PADDING 2
+#ifdef TORUS
+// A power of two wider than the hive with its neighbours. The grid wraps around at its edges, so the hive can drift
+//  across them and never has to be translated back to the center.
+#define BOARD_SIZE 32
+#else
 #define BOARD_SIZE ((N_TILES * 2) + BOARD_PADDING * 2)
+#endif
+
+// The location of (x, y) and the shortest difference between two coordinates, which wrap around on the torus.
+#ifdef TORUS
+#define board_location(x, y) ((((y) & (BOARD_SIZE - 1)) * BOARD_SIZE) + ((x) & (BOARD_SIZE - 1)))
+#define wrap_delta(d) ((((d) + BOARD_SIZE / 2) & (BOARD_SIZE - 1)) - BOARD_SIZE / 2)
+#else
+#define board_location(x, y) ((y) * BOARD_SIZE + (x))
+#define wrap_delta(d) (d)
+#endif
+
+// Distance of a coordinate past the lowest coordinate of the hive (min_x or min_y).
+#define hive_offset(c, min) (((c) - (min) + BOARD_SIZE) % BOARD_SIZE)
+
+// Whether the tile at a location can move, one bit per location. Only the locations of tiles are kept up to date.
+#define N_FREE_WORDS ((BOARD_SIZE * BOARD_SIZE + 63) / 64)
+#define tile_free(board, location) (((board)->free[(location) / 64] >> ((location) % 64)) & 1)
+#define set_tile_free(board, location, value) ((board)->free[(location) / 64] = \
+        ((board)->free[(location) / 64] & ~(1ull << ((location) % 64))) | ((uint64_t) (value) << ((location) % 64)))
 
 // Default MAX_TURNS of 150
 #ifndef MAX_TURNS
 #define MAX_TURNS 150
 #endif
 
+/*
+ * Evaluation features per colour (0 is light, 1 is dark), updated on every move so evaluating a leaf does not
+ *  require a pass over the board. The moments of the tiles on top give their summed squared distance to any cell.
+ */
+struct eval_state {
+    // Amount of tiles around the queen of this colour.
+    unsigned char queen_neighbours[2];
+    // Tiles which cannot move per tile type (type - 1), this includes covered tiles. Set by full_update.
+    unsigned char immobile[2][N_UNIQUE_TILES];
+    // Amount of tiles on top, and the sums of their x, y and x^2 + y^2.
+    unsigned char n_top[2];
+    short sum_x[2], sum_y[2];
+    int sum_squares[2];
+};
+
 struct board {
     uchar tiles[BOARD_SIZE * BOARD_SIZE];
-    bool free[BOARD_SIZE * BOARD_SIZE];
+    uint64_t free[N_FREE_WORDS];
     int turn;  // Use this to derive whose turn it is
 
     struct player players[2];
 
-    int light_queen_position;
-    int dark_queen_position;
+    short light_queen_position;
+    short dark_queen_position;
 
-    int min_x, min_y;
-    int max_x, max_y;
+    // Bounds of the hive, on the torus the hive starts at the min and the max can lie past the edge.
+    signed char min_x, min_y;
+    signed char max_x, max_y;
 
     char n_stacked;
     struct tile_stack stack[TILE_STACK_SIZE];
 
-    int n_children;
+    short n_children;
 
+    // Translation invariant hash of the tiles, derived from zobrist_sum (see tt.c).
     long long zobrist_hash;
-    long long hash_history[MAX_TURNS + 1];
+    uint64_t zobrist_sum;
 
     bool has_updated;
+
+    // Location of every tile indexed by to_tile_index - 1, or -1 if the tile is not placed yet.
+    // Tiles covered by a beetle keep the location of their stack, and have their bit set in covered.
+    short tile_locations[N_TILES * 2];
+    unsigned int covered;
+
+    struct eval_state eval;
 };
 
+// Every node copies its board, so apart from its grids it only holds a few cache lines.
+_Static_assert(sizeof(struct board) - offsetof(struct board, turn) <= 192, "The board state besides its grids grew");
+_Static_assert(MAX_TURNS < INT16_MAX && BOARD_SIZE * BOARD_SIZE < INT16_MAX, "Locations and turns are kept in shorts");
+
+/*
+ * Hashes of the positions of a game, kept once per game instead of being copied into every board. The positions
+ *  played so far are pushed by the game, searches push the positions along their path on top and pop them again.
+ * Positions are stored at their turn, from the turn of the first known position up to n.
+ */
+struct hash_history {
+    int first, n;
+    long long hashes[MAX_TURNS + 1];
+    // Tiles on the board in every position, a placement cannot be undone so earlier positions never repeat.
+    uchar n_placed[MAX_TURNS + 1];
+};
+
+#define tile_on_top(board, i) ((board)->tile_locations[i] != -1 && ((board)->covered & (1u << (i))) == 0)
+
+// Feature planes of a board for the neural networks, one per tile and one holding the player.
+#define N_PLANES (N_TILES * 2 + 1)
+
+/*
+ * A position in 32 bytes, the same wherever the hive lies on the board, see board_pack.
+ * Every tile (indexed by to_tile_index - 1) has 10 bits with its x and its y shifted by 5, relative to the lowest x
+ *  and y of the hive, or PACKED_NOT_PLACED. The height in a stack of the beetles follows in 3 bits per beetle, and the
+ *  turn takes the last 16 bits.
+ */
+struct packed_position {
+    uint64_t bits[4];
+};
+
+#define PACKED_NOT_PLACED 0x3FF
+#define PACKED_BEETLES_OFFSET (N_TILES * 2 * 10)
+#define PACKED_TURN_OFFSET 240
+
+// The hexagonal grid has six rotations, each with or without a reflection.
+#define N_SYMMETRIES 12
+
 
 void print_board(struct board* board);
 void print_matrix(struct board* board);
 struct board* init_board();
+void reset_board(struct board* board);
+void set_board_information(struct board* board);
 
-void get_min_x_y(struct board* board, int* min_x, int* min_y);
-void get_max_x_y(struct board* board, int* max_x, int* max_y);
+void get_min_x_y(struct board* board, signed char* min_x, signed char* min_y);
+void get_max_x_y(struct board* board, signed char* max_x, signed char* max_y);
+#ifdef TORUS
+void set_hive_bounds(struct board* board);
+#endif
+int hive_relative_location(struct board* board, int location);
+int hive_absolute_location(struct board* board, int location);
+void index_tile_locations(struct board* board);
+void index_eval_state(struct board* board);
+void eval_track_tile(struct board* board, uchar tile, int location, int sign);
+void eval_translate(struct board* board, int dx, int dy);
+void eval_track_queens(struct board* board, int location, int previous_location, bool placed_on_empty);
 int count_tiles_around(struct board* board, int position);
 void translate_board(struct board* board);
 void translate_board_22(struct board* board);
 int finished_board(struct board* board);
+void board_planes(struct board* board, int player, uchar* planes);
+void board_pack(struct board* board, struct packed_position* packed);
+void board_unpack(struct board* board, struct packed_position* packed);
+bool packed_tile_location(struct packed_position* packed, int index, int* x, int* y);
+int packed_tile_height(struct packed_position* packed, int index);
+void packed_transform(struct packed_position* packed, int symmetry, struct packed_position* transformed);
+int packed_transform_location(struct packed_position* packed, int symmetry, int location);
+int board_canonical(struct board* board, struct packed_position* canonical);
+void history_start(struct hash_history* history, struct hash_history* game, struct board* root);
+void history_push(struct hash_history* history, struct board* board);
+void history_pop(struct hash_history* history);
+int history_repetitions(struct hash_history* history);
 
 #endif //THEHIVE_BOARD_H
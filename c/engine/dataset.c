@@ -0,0 +1,114 @@
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "dataset.h"
+
+/*
+ * Maps a file of self-play records, and finds the offset of every record. A record cut off at the end of the file
+ *  (the generator was stopped while writing) is left out.
+ * Returns NULL if the file cannot be read or does not match the board layout of this library.
+ */
+struct dataset *dataset_open(char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "Cannot open dataset '%s'.\n", path);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t) sizeof(struct dataset_header)) {
+        fprintf(stderr, "Dataset '%s' has no header.\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    uchar *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Cannot map dataset '%s'.\n", path);
+        return NULL;
+    }
+
+    struct dataset_header *header = (struct dataset_header *) data;
+    if (memcmp(header->magic, DATASET_MAGIC, sizeof(DATASET_MAGIC)) != 0
+        || header->n_planes != N_PLANES || header->board_size != BOARD_SIZE || header->policy_size != POLICY_SIZE) {
+        fprintf(stderr, "Dataset '%s' does not match the board layout.\n", path);
+        munmap(data, st.st_size);
+        return NULL;
+    }
+
+    struct dataset *dataset = malloc(sizeof(struct dataset));
+    dataset->data = data;
+    dataset->size = st.st_size;
+    dataset->n_records = 0;
+
+    int capacity = 1024;
+    dataset->offsets = malloc(capacity * sizeof(size_t));
+
+    size_t offset = sizeof(struct dataset_header);
+    while (offset + sizeof(struct dataset_position) <= dataset->size) {
+        struct dataset_position *position = (struct dataset_position *) &data[offset];
+        size_t length = sizeof(struct dataset_position) + position->n_policy * sizeof(struct dataset_policy);
+        if (offset + length > dataset->size) break;
+
+        if (dataset->n_records == capacity) {
+            capacity *= 2;
+            dataset->offsets = realloc(dataset->offsets, capacity * sizeof(size_t));
+        }
+        dataset->offsets[dataset->n_records++] = offset;
+        offset += length;
+    }
+    return dataset;
+}
+
+void dataset_close(struct dataset *dataset) {
+    munmap(dataset->data, dataset->size);
+    free(dataset->offsets);
+    free(dataset);
+}
+
+int dataset_size(struct dataset *dataset) {
+    return dataset->n_records;
+}
+
+/*
+ * Expands a record to the N_PLANES planes of board_planes (with the hive centered) and the full policy of
+ *  POLICY_SIZE, after applying one of the N_SYMMETRIES symmetries to it; symmetry 0 gives the record as it was played.
+ * Returns the outcome of the game for the player to move.
+ */
+int dataset_get(struct dataset *dataset, int index, int symmetry, uchar *planes, float *policy) {
+    struct dataset_position *position = (struct dataset_position *) &dataset->data[dataset->offsets[index]];
+
+    struct packed_position transformed;
+    packed_transform(&position->position, symmetry, &transformed);
+
+    struct board board;
+    board_unpack(&board, &transformed);
+    board_planes(&board, board.turn % 2, planes);
+
+    memset(policy, 0, POLICY_SIZE * sizeof(float));
+    struct dataset_policy *entries = (struct dataset_policy *) (position + 1);
+    for (int i = 0; i < position->n_policy; i++) {
+        int tile = entries[i].encoding / (BOARD_SIZE * BOARD_SIZE);
+        int location = entries[i].encoding % (BOARD_SIZE * BOARD_SIZE);
+        if (symmetry != 0) location = packed_transform_location(&position->position, symmetry, location);
+        if (location == -1) continue;
+
+        policy[tile * BOARD_SIZE * BOARD_SIZE + location] = entries[i].probability;
+    }
+    return position->outcome;
+}
+
+/*
+ * Writes the outcome of every record, without expanding them.
+ */
+void dataset_outcomes(struct dataset *dataset, float *outcomes) {
+    for (int i = 0; i < dataset->n_records; i++) {
+        outcomes[i] = ((struct dataset_position *) &dataset->data[dataset->offsets[i]])->outcome;
+    }
+}
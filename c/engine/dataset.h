@@ -0,0 +1,54 @@
+
+#ifndef HIVE_DATASET_H
+#define HIVE_DATASET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "board.h"
+#include "utils.h"
+
+/*
+ * Reader of the self-play records written by the C++ engine (cpp/ml/self_play.h).
+ * The file is memory-mapped, the positions are only expanded to planes when they are read.
+ */
+
+#define POLICY_SIZE (N_TILES * BOARD_SIZE * BOARD_SIZE)
+
+#define DATASET_MAGIC "HIVESP3"
+
+#pragma pack(push, 1)
+struct dataset_header {
+    char magic[8];
+    uint32_t n_planes;
+    uint32_t board_size;
+    uint32_t policy_size;
+};
+
+struct dataset_position {
+    struct packed_position position;
+    int8_t outcome;
+    uint16_t n_policy;
+};
+
+struct dataset_policy {
+    uint16_t encoding;
+    float probability;
+};
+#pragma pack(pop)
+
+struct dataset {
+    uchar *data;
+    size_t size;
+    int n_records;
+    // Offset in the file of every record.
+    size_t *offsets;
+};
+
+struct dataset *dataset_open(char *path);
+void dataset_close(struct dataset *dataset);
+int dataset_size(struct dataset *dataset);
+
+int dataset_get(struct dataset *dataset, int index, int symmetry, uchar *planes, float *policy);
+void dataset_outcomes(struct dataset *dataset, float *outcomes);
+
+#endif //HIVE_DATASET_H
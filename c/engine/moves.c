@@ -28,6 +28,19 @@ struct node *default_init() {
 
 struct node *(*dedicated_add_child)(struct node *node, struct board *board) = default_add_child;
 
+// Overrides dedicated_add_child for the searches of one thread when it is set, so a search can allocate its own node
+//  data without changing the allocator of searches on other threads.
+__thread struct node *(*thread_add_child)(struct node *node, struct board *board) = NULL;
+
+static inline struct node *new_child(struct node *node, struct board *board) {
+    if (thread_add_child != NULL) return thread_add_child(node, board);
+    return dedicated_add_child(node, board);
+}
+
+// Amount of nodes generate_children expanded, and the limit on it for benchmarks (0 is no limit).
+unsigned long long n_expansions = 0;
+unsigned long long max_expansions = 0;
+
 struct node *(*dedicated_init)() = default_init;
 
 int to_tile_index(unsigned char tile) {
@@ -52,6 +65,22 @@ int to_tile_index(unsigned char tile) {
     return sum + n;
 }
 
+/*
+ * The tile with the given index of to_tile_index.
+ */
+uchar from_tile_index(int index) {
+    int color = (index - 1) / N_TILES;
+    int n = (index - 1) % N_TILES;
+
+    int types[N_UNIQUE_TILES] = {L_ANT, L_GRASSHOPPER, L_BEETLE, L_SPIDER, L_QUEEN};
+    int counts[N_UNIQUE_TILES] = {N_ANTS, N_GRASSHOPPERS, N_BEETLES, N_SPIDERS, N_QUEENS};
+    int t = 0;
+    while (n >= counts[t]) {
+        n -= counts[t++];
+    }
+    return (color << COLOR_SHIFT) | types[t] | ((n + 1) << NUMBER_SHIFT);
+}
+
 int sum_hive_tiles(struct board *board) {
     return N_TILES * 2 - (
             board->players[0].queens_left +
@@ -95,37 +124,76 @@ struct tile_stack *get_from_stack(struct board *board, int location, bool pop) {
     return highest_tile;
 }
 
+/*
+ * Depth first search for articulation points (Tarjan), a tile which is an articulation point splits the hive
+ *  when it is removed and therefore cannot move. Order and low are indexed by tile index - 1.
+ */
+void find_articulation(struct board *board, int location, int parent, int *timer,
+                       unsigned char *order, unsigned char *low) {
+    int v = to_tile_index(board->tiles[location]) - 1;
+    order[v] = low[v] = ++(*timer);
+
+    int children = 0;
+    int *points = get_points_around(location / BOARD_SIZE, location % BOARD_SIZE);
+    for (int i = 0; i < 6; i++) {
+        int next = points[i];
+        if (board->tiles[next] == EMPTY || next == parent) continue;
+
+        int w = to_tile_index(board->tiles[next]) - 1;
+        if (order[w] != 0) {
+            low[v] = MIN(low[v], order[w]);
+            continue;
+        }
+
+        find_articulation(board, next, location, timer, order, low);
+        low[v] = MIN(low[v], low[w]);
+        if (low[w] >= order[v] && parent != -1) {
+            set_tile_free(board, location, false);
+        }
+        children++;
+    }
+    if (parent == -1 && children > 1) {
+        set_tile_free(board, location, false);
+    }
+}
+
+/*
+ * Recomputes which tiles are free to move, and counts the immobile tiles per colour and type for the evaluation.
+ */
 void full_update(struct board *board) {
-    int n_updated = 0;
-    int to_update = sum_hive_tiles(board);
+    unsigned char order[N_TILES * 2] = {0};
+    unsigned char low[N_TILES * 2];
+    int timer = 0;
+    int root = -1;
 
-#ifdef CENTERED
-    int ly = board->min_y, hy = board->max_y + 1;
-    int lx = board->min_x, hx = board->max_x + 1;
-#else
-    int ly = 0, hy = BOARD_SIZE;
-    int lx = 0, hx = BOARD_SIZE;
-#endif
+    for (int i = 0; i < N_TILES * 2; i++) {
+        // Dont check tiles which are not on the board, or which are covered by a beetle.
+        if (!tile_on_top(board, i)) continue;
 
-//    int first_tile = -1;
-    for (int x = lx; x < hx; x++) {
-        if (n_updated == to_update) break;
-        for (int y = ly; y < hy; y++) {
-            if (n_updated == to_update) break;
-            // Dont check empty tiles, or tiles which could already move before this.
-            if (board->tiles[y * BOARD_SIZE + x] == EMPTY) continue;
+        root = board->tile_locations[i];
+        set_tile_free(board, root, true);
+    }
+    if (root != -1) find_articulation(board, root, -1, &timer, order, low);
 
-//            first_tile = y * BOARD_SIZE + x;
+    struct eval_state *eval = &board->eval;
+    memset(&eval->immobile, 0, sizeof(eval->immobile));
+    for (int i = 0; i < TILE_STACK_SIZE; i++) {
+        struct tile_stack *ts = &board->stack[i];
+        if (ts->location == -1) continue;
 
-            // Allow everything at first, then let articulation fix this.
-            n_updated++;
-            board->free[y * BOARD_SIZE + x] = can_move(board, x, y);
-        }
+        // Covered tiles cannot move, but the tile on top of them can always move off the stack.
+        set_tile_free(board, ts->location, true);
+        eval->immobile[(ts->type & COLOR_MASK) >> COLOR_SHIFT][(ts->type & TILE_MASK) - 1]++;
     }
+    for (int i = 0; i < N_TILES * 2; i++) {
+        if (!tile_on_top(board, i)) continue;
 
-//    print_board(board);
-//    articulation(board, first_tile);
-    // TODO: After articulation, set all stacked beetles to 'free = true', because they are stacked.
+        int location = board->tile_locations[i];
+        if (tile_free(board, location)) continue;
+
+        uchar tile = board->tiles[location];
+        eval->immobile[(tile & COLOR_MASK) >> COLOR_SHIFT][(tile & TILE_MASK) - 1]++;
+    }
 }
 
 void update_can_move(struct board *board, int location, int previous_location) {
@@ -137,13 +205,13 @@ void update_can_move(struct board *board, int location, int previous_location) {
     full_update(board);
     return;
 
-    board->free[location] = true;
+    set_tile_free(board, location, true);
 
     int n_neighbours = 0;
     if (previous_location != -1) {
         // If the previous tile is not empty, this tile is not necessarily free.
         if (board->tiles[previous_location] == EMPTY)
-            board->free[previous_location] = false;
+            set_tile_free(board, previous_location, false);
 
         // Check around previous location
         int *points = get_points_around(previous_location / BOARD_SIZE, previous_location % BOARD_SIZE);
@@ -158,7 +226,7 @@ void update_can_move(struct board *board, int location, int previous_location) {
 
             n_neighbours++;
             // For all neighbours, update whether or not they can move.
-            board->free[py * BOARD_SIZE + px] = can_move(board, px, py);
+            set_tile_free(board, py * BOARD_SIZE + px, can_move(board, px, py));
         }
     }
     int *points = get_points_around(location / BOARD_SIZE, location % BOARD_SIZE);
@@ -174,15 +242,35 @@ void update_can_move(struct board *board, int location, int previous_location) {
         }
         n_neighbours++;
         // For all neighbours, update whether or not they can move.
-        board->free[py * BOARD_SIZE + px] = can_move(board, px, py);
+        set_tile_free(board, py * BOARD_SIZE + px, can_move(board, px, py));
     }
 }
 
+#ifdef TORUS
+/*
+ * Returns whether moving a tile from the previous location to the location can change the bounds of the hive, which
+ *  only happens when it leaves a line at the edge of the hive or lands outside of it.
+ */
+static bool changes_hive_bounds(struct board *board, int location, int previous_location) {
+    int width = board->max_x - board->min_x, height = board->max_y - board->min_y;
+    if (hive_offset(location % BOARD_SIZE, board->min_x) > width
+        || hive_offset(location / BOARD_SIZE, board->min_y) > height)
+        return true;
+    if (previous_location == -1) return false;
+
+    int old_x = hive_offset(previous_location % BOARD_SIZE, board->min_x);
+    int old_y = hive_offset(previous_location / BOARD_SIZE, board->min_y);
+    return old_x == 0 || old_y == 0 || old_x == width || old_y == height;
+}
+#endif
+
 /*
  * Adds all available moves to a node as children.
  */
 void add_child(struct node *node, int location, int type, int previous_location) {
     struct tile_stack *ts;
+    // Heights of the tile in its stack before and after the move, for the hash.
+    int height = 0, old_height = 0;
     if (node->board->turn == MAX_TURNS - 1) {
         return;
     }
@@ -202,7 +290,7 @@ void add_child(struct node *node, int location, int type, int previous_location)
         // No valid moves are available
         board->turn++;
 
-        struct node *child = dedicated_add_child(node, board);
+        struct node *child = new_child(node, board);
 
         child->move.location = 0;
         child->move.previous_location = 0;
@@ -237,10 +325,19 @@ void add_child(struct node *node, int location, int type, int previous_location)
     } else {
         ts = get_from_stack(board, previous_location, true);
         board->tiles[previous_location] = (ts == NULL ? EMPTY : ts->type);
+        eval_track_tile(board, type, previous_location, -1);
+
+        // The tile below is exposed again.
+        if (ts != NULL) {
+            old_height = ts->z + 1;
+            board->covered &= ~(1u << (to_tile_index(ts->type) - 1));
+            eval_track_tile(board, ts->type, previous_location, 1);
+        }
     }
 
     // If this move is on top of an existing tile, store this tile in the stack
-    if (board->tiles[location] != EMPTY) {
+    bool placed_on_empty = board->tiles[location] == EMPTY;
+    if (!placed_on_empty) {
         for (int i = 0; i < TILE_STACK_SIZE; i++) {
             if (board->stack[i].location == -1) {
                 // Get highest tile from stack
@@ -250,12 +347,15 @@ void add_child(struct node *node, int location, int type, int previous_location)
                 board->stack[i].location = location;
                 board->stack[i].type = board->tiles[location];
                 board->stack[i].z = (ts == NULL ? 0 : ts->z + 1);
+                height = board->stack[i].z + 1;
                 break;
             }
         }
 
         // This is to track all the stacked tiles in a simple list to help cloning.
         board->n_stacked++;
+        board->covered |= 1u << (to_tile_index(board->tiles[location]) - 1);
+        eval_track_tile(board, board->tiles[location], location, -1);
     }
 
     // Do this for easier board-finished state checking (dont have to take into account beetles).
@@ -266,21 +366,48 @@ void add_child(struct node *node, int location, int type, int previous_location)
     }
 
     // Update the zobrist hash for this child
-    zobrist_hash(board, location, previous_location, type);
+    zobrist_hash(board, location, previous_location, type, height, old_height);
 
-    // Store hash history
-    board->hash_history[board->turn] = board->zobrist_hash;
     board->tiles[location] = type;
+    board->tile_locations[to_tile_index(type) - 1] = location;
+    eval_track_tile(board, type, location, 1);
+    eval_track_queens(board, location, previous_location, placed_on_empty);
     board->turn++;
 
     board->has_updated = false;
 //    update_can_move(board, location, previous_location);
 
-    // Set min and max tile positions to speedup translation.
     int x = location % BOARD_SIZE;
     int y = location / BOARD_SIZE;
 
-#ifdef CENTERED
+#if defined(TORUS)
+    // The hive is never translated on the torus, only where it starts is tracked.
+    int old_min_x = board->min_x, old_min_y = board->min_y;
+    if (changes_hive_bounds(board, location, previous_location))
+        set_hive_bounds(board);
+
+    // The sum of the hash and the moments are relative to the start of the hive, which moves at most a line. The
+    //  placed tile can lie before the old start, so it is taken out and added again relative to the new start.
+    if (board->min_x != old_min_x || board->min_y != old_min_y) {
+        int dx = wrap_delta(old_min_x - board->min_x);
+        int dy = wrap_delta(old_min_y - board->min_y);
+        int new_min_x = board->min_x, new_min_y = board->min_y;
+
+        board->min_x = old_min_x;
+        board->min_y = old_min_y;
+        zobrist_hash(board, -1, location, type, 0, height);
+        eval_track_tile(board, type, location, -1);
+
+        zobrist_translate(board, MAX(-dy, 0) * BOARD_SIZE + MAX(-dx, 0), MAX(dy, 0) * BOARD_SIZE + MAX(dx, 0));
+        eval_translate(board, dx, dy);
+
+        board->min_x = new_min_x;
+        board->min_y = new_min_y;
+        zobrist_hash(board, location, -1, type, height, 0);
+        eval_track_tile(board, type, location, 1);
+    }
+#elif defined(CENTERED)
+    // Set min and max tile positions to speedup translation.
     int old_x = previous_location % BOARD_SIZE;
     int old_y = previous_location / BOARD_SIZE;
 
@@ -306,8 +433,9 @@ void add_child(struct node *node, int location, int type, int previous_location)
 #else
     translate_board_22(board);
 #endif
+    zobrist_rebase(board);
 
-    struct node *child = dedicated_add_child(node, board);
+    struct node *child = new_child(node, board);
     child->move.previous_location = previous_location;
     child->move.location = location;
 
@@ -339,12 +467,12 @@ void initialize_points_around() {
     for (int y = 0; y < BOARD_SIZE; y++) {
         for (int x = 0; x < BOARD_SIZE; x++) {
             int *points = points_around[y * BOARD_SIZE + x];
-            points[0] = (y - 1) * BOARD_SIZE + (x - 1);
-            points[1] = (y - 1) * BOARD_SIZE + (x + 0);
-            points[2] = (y + 0) * BOARD_SIZE + (x - 1);
-            points[3] = (y + 0) * BOARD_SIZE + (x + 1);
-            points[4] = (y + 1) * BOARD_SIZE + (x + 0);
-            points[5] = (y + 1) * BOARD_SIZE + (x + 1);
+            points[0] = board_location(x - 1, y - 1);
+            points[1] = board_location(x + 0, y - 1);
+            points[2] = board_location(x - 1, y + 0);
+            points[3] = board_location(x + 1, y + 0);
+            points[4] = board_location(x + 0, y + 1);
+            points[5] = board_location(x + 1, y + 1);
         }
     }
 }
@@ -357,6 +485,100 @@ int *get_points_around(int y, int x) {
     return points_around[y * BOARD_SIZE + x];
 }
 
+/*
+ * The two cells shared by a location and its neighbour in direction p (in the order of get_points_around),
+ *  a tile moving in direction p has to slide through the gap between these.
+ */
+const int slide_gates[6][2] = {{2, 1}, {3, 0}, {0, 4}, {1, 5}, {2, 5}, {3, 4}};
+
+/*
+ * Indexed by the occupancy mask of the 6 cells around a location.
+ * slide_directions contains the directions in which the gap is not closed off by two tiles.
+ * crawl_directions contains the empty directions which can be reached while touching a tile of the gap.
+ */
+unsigned char slide_directions[64];
+unsigned char crawl_directions[64];
+
+// Index of the neighbour at offset (dx, dy) in the order of get_points_around, as [dy + 1][dx + 1].
+const int neighbour_directions[3][3] = {{0, 1, -1}, {2, -1, 3}, {-1, 4, 5}};
+
+void initialize_slide_directions() {
+    for (int mask = 0; mask < 64; mask++) {
+        slide_directions[mask] = crawl_directions[mask] = 0;
+        for (int d = 0; d < 6; d++) {
+            int gate = (1 << slide_gates[d][0]) | (1 << slide_gates[d][1]);
+            if ((mask & gate) == gate) continue;
+
+            slide_directions[mask] |= 1 << d;
+            if ((mask & gate) != 0 && (mask & (1 << d)) == 0)
+                crawl_directions[mask] |= 1 << d;
+        }
+    }
+}
+
+/*
+ * Returns the occupancy mask of the cells around a location, bit p is set if the p-th point around it is not empty.
+ */
+static inline int neighbour_mask(struct board *board, int location) {
+    int *points = points_around[location];
+    int mask = 0;
+    for (int p = 0; p < 6; p++) {
+        mask |= (board->tiles[points[p]] != EMPTY) << p;
+    }
+    return mask;
+}
+
+/*
+ * Finds the locations a tile at origin can walk to, the tile itself has to be removed from the board beforehand.
+ * If steps is -1, the tile is an ant and walks any distance along the hive, all reachable locations are stored.
+ * Otherwise, only the locations reached after exactly that many crawling steps are stored.
+ * Returns the amount of locations stored in reachable.
+ */
+int find_reachable(struct board *board, int origin, int steps, int *reachable) {
+    unsigned long long visited[(BOARD_SIZE * BOARD_SIZE + 63) / 64] = {0};
+    // Every location enters the queue once, and is stored with its neighbour mask.
+    int queue[REACHABLE_QUEUE_SIZE];
+    unsigned int head = 0, tail = 0;
+    int n_reachable = 0;
+    bool ant = steps == -1;
+
+    if (ant) visited[origin / 64] |= 1ull << (origin % 64);
+    queue[tail++ & (REACHABLE_QUEUE_SIZE - 1)] = origin << 6 | neighbour_mask(board, origin);
+
+    for (int step = 0; head != tail && (ant || step < steps); step++) {
+        unsigned int layer_end = tail;
+        while (head != layer_end) {
+            int entry = queue[head++ & (REACHABLE_QUEUE_SIZE - 1)];
+            int location = entry >> 6;
+            int mask = entry & 63;
+            int directions = ant ? slide_directions[mask] & ~mask : crawl_directions[mask];
+
+            int *points = points_around[location];
+            for (int d = 0; d < 6; d++) {
+                if ((directions & (1 << d)) == 0) continue;
+
+                int point = points[d];
+                if (visited[point / 64] & (1ull << (point % 64))) continue;
+
+                int point_mask = neighbour_mask(board, point);
+                // Ants still have to stay connected to the hive.
+                if (point_mask == 0) continue;
+
+                visited[point / 64] |= 1ull << (point % 64);
+                queue[tail++ & (REACHABLE_QUEUE_SIZE - 1)] = point << 6 | point_mask;
+                if (ant) reachable[n_reachable++] = point;
+            }
+        }
+    }
+    if (ant) return n_reachable;
+
+    // The last layer of the queue holds the locations reached after all steps.
+    while (head != tail) {
+        reachable[n_reachable++] = queue[head++ & (REACHABLE_QUEUE_SIZE - 1)] >> 6;
+    }
+    return n_reachable;
+}
+
 /*
  * Generates the placing moves, only allowed to place next to allied tiles.
  */
@@ -371,7 +593,7 @@ void generate_placing_moves(struct node *node, int type) {
 
     struct board *board = node->board;
 
-#ifdef CENTERED
+#if defined(CENTERED) || defined(TORUS)
     int initial_position = (BOARD_SIZE / 2) * BOARD_SIZE + BOARD_SIZE / 2;
 #else
     int initial_position = (2) * BOARD_SIZE + 2;
@@ -386,127 +608,55 @@ void generate_placing_moves(struct node *node, int type) {
         return;
     }
 
-    int n_encountered = 0;
-    int to_encounter = sum_hive_tiles(node->board);
+    bool is_added[BOARD_SIZE * BOARD_SIZE] = {0};
 
-#ifdef CENTERED
-    int ly = board->min_y, hy = board->max_y + 1;
-    int lx = board->min_x, hx = board->max_x + 1;
-#else
-    int ly = 0, hy = BOARD_SIZE;
-    int lx = 0, hx = BOARD_SIZE;
-#endif
+    // Placing is only allowed next to allied tiles, so only the neighbours of those are checked.
+    int start = (color >> COLOR_SHIFT) * N_TILES;
+    for (int i = start; i < start + N_TILES; i++) {
+        if (!tile_on_top(board, i)) continue;
 
-    bool is_added[BOARD_SIZE * BOARD_SIZE] = {0};
+        int location = board->tile_locations[i];
+        // Get points around this point
+        int *points = get_points_around(location / BOARD_SIZE, location % BOARD_SIZE);
+        for (int p = 0; p < 6; p++) {
+            int point = points[p];
+            // Check if its empty
+            if (board->tiles[point] != EMPTY) continue;
 
-    for (int y = ly; y < hy; y++) {
-        if (n_encountered == to_encounter) break;
-        for (int x = lx; x < hx; x++) {
-            if (n_encountered == to_encounter) break;
-
-            // Skip empty tiles
-            if (board->tiles[y * BOARD_SIZE + x] == EMPTY) continue;
-
-            n_encountered++;
-            // Get points around this point
-            int *points = get_points_around(y, x);
-            for (int p = 0; p < 6; p++) {
-                int point = points[p];
-                // Check if its empty
-                if (board->tiles[point] != EMPTY) continue;
-
-                // Check if we added this location earlier, if so, remove this (reduce amount of duplicate nodes)
-                if (is_added[point]) continue;
-                is_added[point] = true;
-
-                // Check for all neighbours of this point if its the same colour as the colour of the
-                //  passed tile.
-                int invalid = 0;
-                int yy = point / BOARD_SIZE;
-                int xx = point % BOARD_SIZE;
-                int *neighbor_points = get_points_around(yy, xx);
-                for (int np = 0; np < 6; np++) {
-                    int np_index = neighbor_points[np];
-                    if (np_index < 0 || np_index >= BOARD_SIZE * BOARD_SIZE) continue;
-
-                    if (board->tiles[np_index] == EMPTY) continue;
-
-                    // Check if every tile around it has the same colour as the passed tile colour.
-                    if ((board->tiles[np_index] & COLOR_MASK) != color) {
-                        invalid = 1;
-                        break;
-                    }
+            // Check if we added this location earlier, if so, remove this (reduce amount of duplicate nodes)
+            if (is_added[point]) continue;
+            is_added[point] = true;
+
+            // Check for all neighbours of this point if its the same colour as the colour of the
+            //  passed tile.
+            int invalid = 0;
+            int yy = point / BOARD_SIZE;
+            int xx = point % BOARD_SIZE;
+            int *neighbor_points = get_points_around(yy, xx);
+            for (int np = 0; np < 6; np++) {
+                int np_index = neighbor_points[np];
+                if (np_index < 0 || np_index >= BOARD_SIZE * BOARD_SIZE) continue;
+
+                if (board->tiles[np_index] == EMPTY) continue;
+
+                // Check if every tile around it has the same colour as the passed tile colour.
+                if ((board->tiles[np_index] & COLOR_MASK) != color) {
+                    invalid = 1;
+                    break;
                 }
+            }
 
-                // If any neighbour of this point is another colour, check another point.
-                if (invalid) continue;
+            // If any neighbour of this point is another colour, check another point.
+            if (invalid) continue;
 
-                add_child(node, point, type, -1);
-            }
+            add_child(node, point, type, -1);
         }
     }
 }
 
-int add_if_unique(int *array, int n, int value) {
-    for (int i = 0; i < n; i++) {
-        if (array[i] == value) return 0;
-    }
-    array[n] = value;
-    return 1;
-}
-
-//bool visited[N_TILES * 2];
-//int tin[N_TILES * 2], low[N_TILES * 2];
-//int timer;
-//void find_articulation(struct board *board, int idx, int parent) {
-//    int v = to_tile_index(board->tiles[idx].type);
-//    visited[v] = true;
-//    tin[v] = low[v] = timer++;
-//
-//    int children = 0;
-//
-//    int *points = get_points_around(idx / BOARD_SIZE, idx % BOARD_SIZE);
-//    for (int i = 0; i < 6; i++) {
-//        int to_idx = points[i];
-//        // Skip empty tiles
-//        if (board->tiles[to_idx].type == EMPTY) continue;
-//
-//        int to = to_tile_index(board->tiles[to_idx].type);
-//        // Dont go back to parent
-//        if (to_idx == parent) continue;
-//
-//        if (visited[to]) {
-//            low[v] = MIN(low[v], tin[to]);
-//        } else {
-//            find_articulation(board, to_idx, idx);
-//            low[v] = MIN(low[v], low[to]);
-//            if (low[to] >= tin[v] && parent != -1) {
-//                // This is a node which cannot be removed.
-//                board->tiles[idx].free = false;
-//            }
-//            children++;
-//        }
-//    }
-//    if (parent == -1 && children > 1) {
-//        board->tiles[idx].free = false;
-//    }
-//}
-//
-//void articulation(struct board* board, int index) {
-//    timer = 0;
-//    memset(&visited, false, sizeof(visited));
-//    memset(&tin, -1, sizeof(tin));
-//    memset(&low, -1, sizeof(low));
-//
-//    find_articulation(board, index, -1);
-//}
-
-
 int connected_components(struct board *board, int index) {
     bool visited[BOARD_SIZE * BOARD_SIZE] = {0};
 
-//    return find_articulation(board, index, -1, is_connected);
-
     int n_connected = 1;
     int frontier[N_TILES * 2];
     int frontier_p = 0; // Frontier pointer.
@@ -546,12 +696,12 @@ void generate_directional_grasshopper_moves(struct node *node, int orig_y, int o
     int x = orig_x + x_incr;
     int y = orig_y + y_incr;
     // It needs to jump at least 1 tile.
-    if (board->tiles[y * BOARD_SIZE + x] != EMPTY) {
+    if (board->tiles[board_location(x, y)] != EMPTY) {
         while (1) {
             x += x_incr;
             y += y_incr;
-            if (board->tiles[y * BOARD_SIZE + x] == EMPTY) {
-                add_child(node, y * BOARD_SIZE + x, tile_type, orig_pos);
+            if (board->tiles[board_location(x, y)] == EMPTY) {
+                add_child(node, board_location(x, y), tile_type, orig_pos);
                 break;
             }
         }
@@ -570,101 +720,36 @@ void generate_grasshopper_moves(struct node *node, int orig_y, int orig_x) {
 }
 
 bool has_neighbour(struct board *board, int location) {
-    int x = location % BOARD_SIZE;
-    int y = location / BOARD_SIZE;
-    int *points = get_points_around(y, x);
-    for (int i = 0; i < 6; i++) {
-        if (board->tiles[points[i]] != EMPTY) {
-            return true;
-        }
-    }
-    return false;
+    return neighbour_mask(board, location) != 0;
 }
 
+/*
+ * Returns whether a tile can slide from (x, y) to the neighbouring (new_x, new_y) without squeezing between two tiles.
+ */
 bool tile_fits(struct board *board, int x, int y, int new_x, int new_y) {
-    bool tl = board->tiles[(y - 1) * BOARD_SIZE + (x - 1)] == EMPTY;
-    bool tr = board->tiles[(y - 1) * BOARD_SIZE + (x + 0)] == EMPTY;
-    bool l = board->tiles[(y + 0) * BOARD_SIZE + (x - 1)] == EMPTY;
-    bool r = board->tiles[(y + 0) * BOARD_SIZE + (x + 1)] == EMPTY;
-    bool bl = board->tiles[(y + 1) * BOARD_SIZE + (x + 0)] == EMPTY;
-    bool br = board->tiles[(y + 1) * BOARD_SIZE + (x + 1)] == EMPTY;
-
-    if (x - new_x == -1 && y - new_y == 0) {
-        // Going to the right
-        return tr || br;
-    } else if (x - new_x == 1 && y - new_y == 0) {
-        // Going to the left
-        return tl || bl;
-    } else if (x - new_x == 1 && y - new_y == 1) {
-        // Going to the top left
-        return l || tr;
-    } else if (x - new_x == 0 && y - new_y == 1) {
-        // Going to the top right
-        return r || tl;
-    } else if (x - new_x == 0 && y - new_y == -1) {
-        // Going to the bottom left
-        return l || br;
-    } else if (x - new_x == -1 && y - new_y == -1) {
-        // Going to the bottom right
-        return r || bl;
-    }
-    print_board(board);
-    fprintf(stderr, "Invalid neighbour found, check the coordinates. (%d,%d)->(%d,%d)\n", x, y, new_x, new_y);
-    exit(1);
+    int dx = wrap_delta(new_x - x), dy = wrap_delta(new_y - y);
+    if (dx < -1 || dx > 1 || dy < -1 || dy > 1) return false;
+
+    int direction = neighbour_directions[dy + 1][dx + 1];
+    return direction != -1 && (slide_directions[neighbour_mask(board, y * BOARD_SIZE + x)] & (1 << direction)) != 0;
 }
 
 void generate_ant_moves(struct node *node, int orig_y, int orig_x) {
     struct board *board = node->board;
+    int origin = orig_y * BOARD_SIZE + orig_x;
 
     // Store tile for temporary removal
-    int tile_type = board->tiles[orig_y * BOARD_SIZE + orig_x];
-    board->tiles[orig_y * BOARD_SIZE + orig_x] = EMPTY;
-
-    int ant_move_buffer[BOARD_SIZE * BOARD_SIZE];// = malloc(BOARD_SIZE * BOARD_SIZE * sizeof(int));
-    int n_ant_moves = 0;
-    int frontier[N_TILES];
-    int frontier_p = 0; // Frontier pointer.
-    int index = orig_y * BOARD_SIZE + orig_x;
-
-    ant_move_buffer[n_ant_moves++] = index;
-    frontier[frontier_p++] = index;
-
-    while (frontier_p != 0) {
-        int i = frontier[--frontier_p];
-        int y = i / BOARD_SIZE;
-        int x = i % BOARD_SIZE;
-
-        int *points = get_points_around(y, x);
-        for (int n = 0; n < 6; n++) {
-            int point = points[n];
-
-            // Ants cannot stack.
-            if (board->tiles[point] != EMPTY) continue;
-
-            // Skip this tile if it has no neighbours
-            // Connected hive requirement.
-            if (!has_neighbour(board, point)) continue;
+    int tile_type = board->tiles[origin];
+    board->tiles[origin] = EMPTY;
 
-            int new_x = point % BOARD_SIZE;
-            int new_y = point / BOARD_SIZE;
-            if (!tile_fits(board, x, y, new_x, new_y)) continue;
+    int reachable[REACHABLE_QUEUE_SIZE];
+    int n_reachable = find_reachable(board, origin, -1, reachable);
 
-            // If a unique tile is added, increment the tracker.
-            int added = add_if_unique(ant_move_buffer, n_ant_moves, points[n]);
-
-            if (added) {
-                n_ant_moves++;
-                frontier[frontier_p++] = points[n];
-            }
-        }
-    }
-    board->tiles[orig_y * BOARD_SIZE + orig_x] = tile_type;
+    board->tiles[origin] = tile_type;
 
     // Generate moves based on these valid ant moves.
-    for (int i = 0; i < n_ant_moves; i++) {
-        // Moving to the same position it already was is not valid.
-        if (ant_move_buffer[i] == orig_y * BOARD_SIZE + orig_x) continue;
-        add_child(node, ant_move_buffer[i], tile_type, orig_y * BOARD_SIZE + orig_x);
+    for (int i = 0; i < n_reachable; i++) {
+        add_child(node, reachable[i], tile_type, origin);
     }
 }
 
@@ -686,32 +771,11 @@ void generate_queen_moves(struct node *node, int y, int x) {
         board->tiles[y * BOARD_SIZE + x] = temp->type;
     }
 
+    // The queen slides along the tiles around it.
     int *points = get_points_around(y, x);
-    for (int p = 0; p < 6; p++) {
-        int point = points[p];
-
-        // Get all tiles which are connected to the queen
-        if (board->tiles[point] == EMPTY) continue;
-
-        int xx = point % BOARD_SIZE;
-        int yy = point / BOARD_SIZE;
-
-        if (!tile_fits(board, x, y, xx, yy)) continue;
-
-        // For all neighbors, if the neighbors neighbors == my neighbors -> valid move.
-        int *neighbor_points = get_points_around(yy, xx);
-        for (int i = 0; i < 6; i++) {
-            if (board->tiles[neighbor_points[i]] != EMPTY) continue;
-
-            for (int j = 0; j < 6; j++) {
-                if (neighbor_points[i] == points[j]) {
-                    if (!tile_fits(board, x, y, points[j] % BOARD_SIZE, points[j] / BOARD_SIZE)) continue;
-
-                    // This tile is connected.
-                    add_child(node, neighbor_points[i], tile_type, y * BOARD_SIZE + x);
-                }
-            }
-        }
+    int directions = crawl_directions[neighbour_mask(board, y * BOARD_SIZE + x)];
+    for (int d = 0; d < 6; d++) {
+        if (directions & (1 << d)) add_child(node, points[d], tile_type, y * BOARD_SIZE + x);
     }
 
     board->tiles[y * BOARD_SIZE + x] = tile_type;
@@ -736,11 +800,10 @@ void generate_beetle_moves(struct node *node, int y, int x) {
 
         board->tiles[y * BOARD_SIZE + x] = EMPTY;
 
+        // Get all tiles which are connected to the beetle
+        int occupied = neighbour_mask(board, y * BOARD_SIZE + x);
         for (int p = 0; p < 6; p++) {
-            // Get all tiles which are connected to the beetle
-            if (board->tiles[points[p]] == EMPTY) continue;
-
-            add_child(node, points[p], tile_type, y * BOARD_SIZE + x);
+            if (occupied & (1 << p)) add_child(node, points[p], tile_type, y * BOARD_SIZE + x);
         }
     } else {
         // Beetle on top of something has no restrictions on movement off of the tile.
@@ -755,74 +818,20 @@ void generate_beetle_moves(struct node *node, int y, int x) {
 
 void generate_spider_moves(struct node *node, int orig_y, int orig_x) {
     struct board *board = node->board;
+    int origin = orig_y * BOARD_SIZE + orig_x;
 
     // Store tile for temporary removal
-    int tile_type = board->tiles[orig_y * BOARD_SIZE + orig_x];
-    board->tiles[orig_y * BOARD_SIZE + orig_x] = EMPTY;
+    int tile_type = board->tiles[origin];
+    board->tiles[origin] = EMPTY;
 
-    int *valid_moves = calloc(sizeof(int), BOARD_SIZE * BOARD_SIZE);
-    int valid_moves_tracker = 0;
+    int reachable[REACHABLE_QUEUE_SIZE];
+    int n_reachable = find_reachable(board, origin, SPIDER_STEPS, reachable);
 
-    // Frontier to track multiple points.
-    int *frontier = calloc(BOARD_SIZE * BOARD_SIZE, sizeof(int));
-    int frontier_p = 0; // Frontier pointer.
-    int *next_frontier = calloc(BOARD_SIZE * BOARD_SIZE, sizeof(int));
-    int next_frontier_p = 0; // Next frontier pointer.
-
-    frontier[frontier_p++] = orig_y * BOARD_SIZE + orig_x;
-
-    for (int iteration = 0; iteration < 3; iteration++) {
-        while (frontier_p > 0) {
-            // Get a point on the frontier
-            int frontier_point = frontier[--frontier_p];
-            int x = frontier_point % BOARD_SIZE;
-            int y = frontier_point / BOARD_SIZE;
-            int *points = get_points_around(y, x);
-
-            // Iterate all points surrounding this frontier.
-            // Generate a list containing all valid moves from the frontier onward.
-            for (int p = 0; p < 6; p++) {
-                int point = points[p];
-                if (board->tiles[point] == EMPTY) continue;
-                int xx = point % BOARD_SIZE;
-                int yy = point / BOARD_SIZE;
-
-                if (!tile_fits(board, x, y, xx, yy)) continue;
-
-                // For all neighbors, if the neighbors neighbors == my neighbors -> valid move.
-                int *neighbor_points = get_points_around(yy, xx);
-                for (int i = 0; i < 6; i++) {
-                    if (board->tiles[neighbor_points[i]] != EMPTY) continue;
-                    for (int j = 0; j < 6; j++) {
-                        if (neighbor_points[i] == points[j]) {
-                            if (!tile_fits(board, x, y, points[j] % BOARD_SIZE, points[j] / BOARD_SIZE)) continue;
-
-                            // If a unique tile is added, increment the tracker.
-                            int added = add_if_unique(valid_moves, valid_moves_tracker, neighbor_points[i]);
-                            if (added) {
-                                valid_moves_tracker++;
-                                next_frontier[next_frontier_p++] = neighbor_points[i];
-                            }
-                        }
-                    }
-                }
-            }
-        }
-        // Swap two frontiers.
-        int *temp = frontier;
-        frontier = next_frontier;
-        next_frontier = temp;
-        frontier_p = next_frontier_p;
-        next_frontier_p = 0;
-    }
-    board->tiles[orig_y * BOARD_SIZE + orig_x] = tile_type;
+    board->tiles[origin] = tile_type;
 
-    for (int i = 0; i < frontier_p; i++) {
-        add_child(node, frontier[i], tile_type, orig_y * BOARD_SIZE + orig_x);
+    for (int i = 0; i < n_reachable; i++) {
+        add_child(node, reachable[i], tile_type, origin);
     }
-    free(valid_moves);
-    free(frontier);
-    free(next_frontier);
 }
 
 bool can_move(struct board *board, int x, int y) {
@@ -864,43 +873,46 @@ void generate_free_moves(struct node *node, int player_bit, int flags) {
     // We do a full update as soon as we want to move.
     update_can_move(board, node->move.location, node->move.previous_location);
 
-#ifdef CENTERED
-    int ly = board->min_y, hy = board->max_y + 1;
-    int lx = board->min_x, hx = board->max_x + 1;
-#else
-    int ly = 0, hy = BOARD_SIZE;
-    int lx = 0, hx = BOARD_SIZE;
-#endif
-
-    for (int y = ly; y < hy; y++) {
-        for (int x = lx; x < hx; x++) {
-            uchar tile = board->tiles[y * BOARD_SIZE + x];
-            if (tile == EMPTY) continue;
-            // Only move your own tiles
-            if ((tile & COLOR_MASK) != player_bit) continue;
-
-            if (!board->free[y * BOARD_SIZE + x]) continue;
-
-            // If this tile can be removed without breaking the hive, add it to the valid moves list.
-            if ((tile & TILE_MASK) == L_GRASSHOPPER) {
-                generate_grasshopper_moves(node, y, x);
-            } else if ((tile & TILE_MASK) == L_BEETLE) {
-                generate_beetle_moves(node, y, x);
-            } else if ((tile & TILE_MASK) == L_ANT) {
-                // Dont move ants if this flag is set.
-                if ((flags & MOVE_NO_ANTS) > 0) {
-                    continue;
-                }
-                generate_ant_moves(node, y, x);
-            } else if ((tile & TILE_MASK) == L_QUEEN) {
-                generate_queen_moves(node, y, x);
-            } else if ((tile & TILE_MASK) == L_SPIDER) {
-                generate_spider_moves(node, y, x);
+    // Only move your own tiles
+    int start = (player_bit >> COLOR_SHIFT) * N_TILES;
+    for (int i = start; i < start + N_TILES; i++) {
+        // Tiles covered by a beetle cannot move.
+        if (!tile_on_top(board, i)) continue;
+
+        int location = board->tile_locations[i];
+        if (!tile_free(board, location)) continue;
+
+        int y = location / BOARD_SIZE;
+        int x = location % BOARD_SIZE;
+        uchar tile = board->tiles[location];
+        bool ant_or_spider = (tile & TILE_MASK) == L_ANT || (tile & TILE_MASK) == L_SPIDER;
+        if ((flags & MOVE_ONLY_ANTS_SPIDERS) && !ant_or_spider) continue;
+
+        // If this tile can be removed without breaking the hive, add it to the valid moves list.
+        if ((tile & TILE_MASK) == L_GRASSHOPPER) {
+            generate_grasshopper_moves(node, y, x);
+        } else if ((tile & TILE_MASK) == L_BEETLE) {
+            generate_beetle_moves(node, y, x);
+        } else if ((tile & TILE_MASK) == L_ANT) {
+            // Dont move ants if this flag is set.
+            if ((flags & MOVE_NO_ANTS) > 0) {
+                continue;
             }
+            generate_ant_moves(node, y, x);
+        } else if ((tile & TILE_MASK) == L_QUEEN) {
+            generate_queen_moves(node, y, x);
+        } else if ((tile & TILE_MASK) == L_SPIDER) {
+            if ((flags & MOVE_NO_SPIDERS) > 0) {
+                continue;
+            }
+            generate_spider_moves(node, y, x);
         }
     }
 }
 
+bool expansion_budget_spent() {
+    return max_expansions != 0 && n_expansions >= max_expansions;
+}
 
 int generate_children(struct node *root, double end_time, int flags) {
     /*
@@ -908,12 +920,13 @@ int generate_children(struct node *root, double end_time, int flags) {
      *   1: No more moves could be generated due to turn limit.
      *   2: Time-budget is spent.
      *   3: Memory is full, no new nodes can be allocated.
+     * With one of the MOVE_PARTIAL flags only part of the moves is generated, and 1 is returned if that part is empty.
      */
 
     // Ensure timely finishing
     struct timespec cur_time;
     clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cur_time);
-    if (to_usec(cur_time) / 1e6 > end_time) return ERR_NOTIME;
+    if (to_usec(cur_time) / 1e6 > end_time || expansion_budget_spent()) return ERR_NOTIME;
 
     // Dont continue generating children if there is no more memory.
     if (max_nodes - n_nodes < 1000) {
@@ -927,15 +940,66 @@ int generate_children(struct node *root, double end_time, int flags) {
 
     // Only generate more nodes if you have no nodes yet
     if (list_empty(&root->children)) {
+        // The later stages of a staged generation expand the same node.
+        if ((flags & MOVE_ONLY_ANTS_SPIDERS) == 0) {
+#pragma omp atomic
+            n_expansions++;
+        }
         generate_moves(root, flags);
 
-        if (list_empty(&root->children)) {
+        if (list_empty(&root->children) && (flags & MOVE_PARTIAL) == 0) {
             add_child(root, -1, 0, -1);
         }
     }
     return list_empty(&root->children);
 }
 
+/*
+ * Index of the move in the policy of the networks. The absolute encoding is the tile of the player with the
+ *  location it moves to, the relative encoding is the tile with the tile it moves next to and the direction.
+ * Returns -1 for a pass.
+ */
+int encode_move(struct move *move, int encoding) {
+    if (move->tile == 0) return -1;
+
+    // Only tiles of the player to move, so the colour is left out.
+    int tile_idx = to_tile_index(move->tile & ~COLOR_MASK) - 1;
+
+    if (encoding == ENCODING_RELATIVE) {
+        return (tile_idx * (N_TILES * 2 + 1) + to_tile_index(move->next_to)) * 7 + move->direction;
+    }
+    return tile_idx * BOARD_SIZE * BOARD_SIZE + move->location;
+}
+
+/*
+ * Generates the children of the node if it has none yet, and writes up to max_children of them in one call.
+ * This saves the Python package a call per child walking the list of children.
+ * The children stay owned by the node. The moves, their encodings and the N_PLANES planes of every child (with the
+ *  player to move in the child) are skipped if their buffer is NULL.
+ * Returns the amount of children written, or the error of generate_children negated.
+ */
+int generate_children_batch(struct node *node, double end_time, struct node **out_children, struct move *out_moves,
+                            int *out_encodings, int encoding, uchar *out_planes, int max_children) {
+    int err = generate_children(node, end_time, 0);
+    if (err) return -err;
+
+    int n = 0;
+    struct list *head;
+    node_foreach(node, head) {
+        if (n == max_children) break;
+        struct node *child = container_of(head, struct node, node);
+
+        if (out_children != NULL) out_children[n] = child;
+        if (out_moves != NULL) out_moves[n] = child->move;
+        if (out_encodings != NULL) out_encodings[n] = encode_move(&child->move, encoding);
+        if (out_planes != NULL) {
+            board_planes(child->board, child->board->turn % 2, &out_planes[n * N_PLANES * BOARD_SIZE * BOARD_SIZE]);
+        }
+        n++;
+    }
+    return n;
+}
+
 
 void generate_moves(struct node *node, int flags) {
     int player_idx = node->board->turn % 2;
@@ -949,7 +1013,16 @@ void generate_moves(struct node *node, int flags) {
     board->n_children = 0;
     // By move 4 for each player, the queen has to be placed.
     if (move == 3 && player->queens_left == 1) {
-        return generate_placing_moves(node, L_QUEEN | player_bit);
+        if ((flags & MOVE_ONLY_ANTS_SPIDERS) == 0)
+            generate_placing_moves(node, L_QUEEN | player_bit);
+        return;
+    }
+
+    // Tiles can only be moved if their queen is on the board.
+    if (flags & MOVE_ONLY_ANTS_SPIDERS) {
+        if (player->queens_left == 0)
+            generate_free_moves(node, player_bit, flags);
+        return;
     }
 
     if (player->spiders_left > 0) {
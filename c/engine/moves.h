@@ -10,29 +10,48 @@
 #include "mm/mm.h"
 #include <time.h>
 
-#define MOVE_NO_ANTS 1 << 0
+// Flags to generate the moves of a node in stages, no pass is added when a stage has no moves.
+#define MOVE_NO_ANTS (1 << 0)
+#define MOVE_NO_SPIDERS (1 << 1)
+#define MOVE_ONLY_ANTS_SPIDERS (1 << 2)
+#define MOVE_PARTIAL (MOVE_NO_ANTS | MOVE_NO_SPIDERS | MOVE_ONLY_ANTS_SPIDERS)
+
+#define SPIDER_STEPS 3
+// Power of two which is larger than the amount of empty locations around a full hive.
+#define REACHABLE_QUEUE_SIZE 256
 
 #define ERR_NOMOVES 1
 #define ERR_NOTIME 2
 #define ERR_NOMEM 3
 
+// Move encodings of the policy networks.
+#define ENCODING_ABSOLUTE 0
+#define ENCODING_RELATIVE 1
+
 #define to_usec(timespec) ((((timespec).tv_sec * 1e9) + (timespec).tv_nsec) / 1e3)
 
 int sum_hive_tiles(struct board *board);
 int* get_points_around(int y, int x);
 void initialize_points_around();
+void initialize_slide_directions();
+int find_reachable(struct board *board, int origin, int steps, int *reachable);
 void add_child(struct node *node, int location, int type, int previous_location);
 void generate_placing_moves(struct node *node, int type);
 void generate_free_moves(struct node *node, int player_bit, int flags);
 void generate_moves(struct node *node, int flags);
 
-void find_articulation(struct board *board, int idx, int parent);
-void articulation(struct board* board, int index);
+void find_articulation(struct board *board, int location, int parent, int *timer,
+                       unsigned char *order, unsigned char *low);
 
 void print_cc_stats();
 int to_tile_index(uchar tile);
+uchar from_tile_index(int index);
 
+bool expansion_budget_spent();
 int generate_children(struct node *root, double end_time, int flags);
+int encode_move(struct move *move, int encoding);
+int generate_children_batch(struct node *node, double end_time, struct node **out_children, struct move *out_moves,
+                            int *out_encodings, int encoding, uchar *out_planes, int max_children);
 
 bool can_move(struct board* board, int x, int y);
 void full_update(struct board *board);
@@ -42,6 +61,9 @@ struct node* default_add_child(struct node* node, struct board* board);
 struct node* default_init();
 
 extern struct node *(*dedicated_add_child)(struct node *node, struct board *board);
+extern __thread struct node *(*thread_add_child)(struct node *node, struct board *board);
 extern struct node *(*dedicated_init)();
+extern unsigned long long n_expansions;
+extern unsigned long long max_expansions;
 
 #endif //THEHIVE_MOVES_H
@@ -94,7 +94,7 @@ unsigned long mix(unsigned long a, unsigned long b, unsigned long c) {
     return c;
 }
 
-unsigned long seed;
+unsigned long game_seed;
 struct node* game_init() {
 
     // Initialize zobrist hashing table
@@ -104,12 +104,11 @@ struct node* game_init() {
         // Initialize transposition table (set flag to -1 to know if its empty)
         tt_init();
 
-        seed = mix(clock(), time(NULL), getpid());
+        // Randomized seed, for the searches which are not given one.
+        game_seed = mix(clock(), time(NULL), getpid());
         // Precompute points around all indices
         initialize_points_around();
-
-        // Randomized seed
-        srand(seed);
+        initialize_slide_directions();
     }
 
     struct board *board = init_board();
@@ -33,6 +33,7 @@ struct node {
     void *data;
 };
 
+extern unsigned long game_seed;
 struct node *game_init();
 struct node* game_pass(struct node* root);
 
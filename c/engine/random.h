@@ -0,0 +1,67 @@
+
+#ifndef HIVE_RANDOM_H
+#define HIVE_RANDOM_H
+
+#include <stdint.h>
+
+/*
+ * Random number generator (xoshiro256**) owned by a single search, so searches on different threads never share
+ *  state, and a search seeded with the same seed makes the same choices.
+ */
+struct rng {
+    uint64_t state[4];
+};
+
+static inline uint64_t rng_rotate(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/*
+ * Expands the seed with splitmix64, which never gives the all-zero state xoshiro cannot leave.
+ */
+static inline void rng_seed(struct rng *rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        rng->state[i] = z ^ (z >> 31);
+    }
+}
+
+static inline uint64_t rng_next(struct rng *rng) {
+    uint64_t *s = rng->state;
+    uint64_t result = rng_rotate(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotate(s[3], 45);
+    return result;
+}
+
+/*
+ * Uniform integer in [0, n) for n > 0, without the bias of a modulo (Lemire's multiply and reject).
+ * Only draws again in the rare case the product lands in the part of the range that would be overrepresented.
+ */
+static inline uint32_t rng_below(struct rng *rng, uint32_t n) {
+    uint64_t product = (rng_next(rng) >> 32) * n;
+    if ((uint32_t) product < n) {
+        uint32_t threshold = -n % n;
+        while ((uint32_t) product < threshold) {
+            product = (rng_next(rng) >> 32) * n;
+        }
+    }
+    return (uint32_t) (product >> 32);
+}
+
+/*
+ * Uniform float in [0, 1).
+ */
+static inline float rng_float(struct rng *rng) {
+    return (float) (rng_next(rng) >> 40) * 0x1.0p-24f;
+}
+
+#endif //HIVE_RANDOM_H
@@ -11,23 +11,199 @@
 struct tt_entry* tt_table = NULL;
 int64_t* zobrist_table = NULL;
 
+/*
+ * The hash of a board sums a key per tile type times X^x * Y^y over the tiles, modulo 2^64, in zobrist_sum.
+ * Moving the whole hive by (dx, dy) multiplies the sum by X^dx * Y^dy, so translating the board updates it in O(1),
+ *  and dividing out the lowest x and y of the hive gives the same zobrist_hash wherever the hive lies.
+ * X and Y are odd so they have an inverse; zobrist_origin holds the inverse of zobrist_location.
+ * The key of a tile is also multiplied by a factor for its height in the stack, so the order of a stack matters.
+ */
+static uint64_t zobrist_location[BOARD_SIZE * BOARD_SIZE];
+static uint64_t zobrist_origin[BOARD_SIZE * BOARD_SIZE];
+static uint64_t zobrist_height[TILE_STACK_SIZE + 1];
+
+static uint64_t random_64() {
+    int32_t r1 = rand(), r2 = rand();
+    return (uint64_t) r1 + ((uint64_t) r2 << 32);
+}
+
+/*
+ * Inverse of an odd number modulo 2^64 by Newton's iteration, every step doubles the correct bits.
+ */
+static uint64_t inverse_64(uint64_t a) {
+    uint64_t inverse = a;
+    for (int i = 0; i < 5; i++) {
+        inverse *= 2 - a * inverse;
+    }
+    return inverse;
+}
+
+/*
+ * The low bits of the sum only depend on the keys, not on the locations, so it is mixed before it is used as a hash.
+ */
+static int64_t zobrist_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return (int64_t) h;
+}
 
 void zobrist_init() {
-    zobrist_table = malloc(BOARD_SIZE * BOARD_SIZE * N_UNIQUE_TILES * 2 * sizeof(int64_t));
-    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE * N_UNIQUE_TILES * 2; i++) {
-        int32_t r1 = rand(), r2 = rand();
-        zobrist_table[i] = r1 + ((int64_t) r2 << 32);
+    zobrist_table = malloc(N_UNIQUE_TILES * 2 * sizeof(int64_t));
+    for (int i = 0; i < N_UNIQUE_TILES * 2; i++) {
+        zobrist_table[i] = (int64_t) random_64();
+    }
+
+    uint64_t x_factor = random_64() | 1, y_factor = random_64() | 1;
+    uint64_t x_inverse = inverse_64(x_factor), y_inverse = inverse_64(y_factor);
+    uint64_t row = 1, row_inverse = 1;
+    for (int y = 0; y < BOARD_SIZE; y++) {
+        uint64_t factor = row, inverse = row_inverse;
+        for (int x = 0; x < BOARD_SIZE; x++) {
+            zobrist_location[y * BOARD_SIZE + x] = factor;
+            zobrist_origin[y * BOARD_SIZE + x] = inverse;
+            factor *= x_factor;
+            inverse *= x_inverse;
+        }
+        row *= y_factor;
+        row_inverse *= y_inverse;
+    }
+
+    // Tiles on the ground keep their plain key.
+    zobrist_height[0] = 1;
+    for (int z = 1; z <= TILE_STACK_SIZE; z++) {
+        zobrist_height[z] = random_64() | 1;
+    }
+}
+
+/*
+ * Key of the tile with the given index (to_tile_index - 1), tiles of the same type and colour share their key.
+ */
+static inline uint64_t zobrist_tile_key(int index) {
+    uchar tile = from_tile_index(index + 1);
+    return zobrist_table[(tile & TILE_MASK) - 1 + N_UNIQUE_TILES * ((tile & COLOR_MASK) >> COLOR_SHIFT)];
+}
+
+/*
+ * Height of the tile on top of the given location, one above the highest tile of its stack.
+ */
+static int zobrist_top_height(struct board *board, int location) {
+    int height = 0;
+    for (int i = 0; i < TILE_STACK_SIZE; i++) {
+        if (board->stack[i].location == location) height = MAX(height, board->stack[i].z + 1);
     }
+    return height;
 }
 
-void zobrist_hash(struct board *board, int location, int old_location, int type) {
-    int tile_type = type & TILE_MASK;
+/*
+ * Moves a tile of the given type in the sum of the board, from old_location at old_height to location at height.
+ * A location of -1 is off the board. The hash itself is updated by zobrist_rebase, once the bounds of the hive
+ *  are known.
+ */
+void zobrist_hash(struct board *board, int location, int old_location, int type, int height, int old_height) {
+    int tile_type = (type & TILE_MASK) - 1;
     int color = (type & COLOR_MASK) >> COLOR_SHIFT;
-    int idx = tile_type + N_UNIQUE_TILES * color;
+    uint64_t key = zobrist_table[tile_type + N_UNIQUE_TILES * color];
+#ifdef TORUS
+    // The sum is kept relative to the start of the hive, as the locations wrap around the torus.
+    if (location >= 0) location = hive_relative_location(board, location);
+    if (old_location >= 0) old_location = hive_relative_location(board, old_location);
+#endif
     if (location >= 0)
-        board->zobrist_hash ^= zobrist_table[location * N_UNIQUE_TILES * 2 + idx];
+        board->zobrist_sum += key * zobrist_height[height] * zobrist_location[location];
     if (old_location >= 0)
-        board->zobrist_hash ^= zobrist_table[old_location * N_UNIQUE_TILES * 2 + idx];
+        board->zobrist_sum -= key * zobrist_height[old_height] * zobrist_location[old_location];
+}
+
+/*
+ * Updates the sum for a translation of the board that moves the tile at from to to.
+ */
+void zobrist_translate(struct board *board, int from, int to) {
+    board->zobrist_sum *= zobrist_location[to] * zobrist_origin[from];
+}
+
+/*
+ * Sets the hash of the board from its sum, relative to the lowest x and y of the hive.
+ */
+void zobrist_rebase(struct board *board) {
+#ifdef TORUS
+    // The sum is already relative to the start of the hive.
+    board->zobrist_hash = zobrist_mix(board->zobrist_sum);
+#else
+    if (board->min_x >= BOARD_SIZE) {
+        // There is no hive yet.
+        board->zobrist_hash = zobrist_mix(board->zobrist_sum);
+        return;
+    }
+    board->zobrist_hash = zobrist_mix(board->zobrist_sum * zobrist_origin[board->min_y * BOARD_SIZE + board->min_x]);
+#endif
+}
+
+/*
+ * Computes the zobrist hash of all tiles on the board, including the ones below beetles.
+ * The bounds of the board (min_x and min_y) have to be set.
+ */
+void hash_board(struct board* board) {
+    if (zobrist_table == NULL)
+        zobrist_init();
+
+    board->zobrist_sum = 0;
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++) {
+        if (board->tiles[i] != EMPTY)
+            zobrist_hash(board, i, -1, board->tiles[i], zobrist_top_height(board, i), 0);
+    }
+    for (int i = 0; i < TILE_STACK_SIZE; i++) {
+        if (board->stack[i].location != -1)
+            zobrist_hash(board, board->stack[i].location, -1, board->stack[i].type, board->stack[i].z, 0);
+    }
+    zobrist_rebase(board);
+}
+
+/*
+ * A zobrist hash which is the same for all symmetries of a position (see board_canonical), hashing the tiles at their
+ *  locations in the canonical form. It is computed from scratch, unlike the incremental hash of the board.
+ */
+int64_t zobrist_canonical(struct board* board) {
+    if (zobrist_table == NULL)
+        zobrist_init();
+
+    struct packed_position canonical;
+    board_canonical(board, &canonical);
+
+    uint64_t sum = 0;
+    for (int i = 0; i < N_TILES * 2; i++) {
+        int x, y;
+        if (!packed_tile_location(&canonical, i, &x, &y)) continue;
+
+        uint64_t key = zobrist_tile_key(i) * zobrist_height[packed_tile_height(&canonical, i)];
+        sum += key * zobrist_location[y * BOARD_SIZE + x];
+    }
+    return zobrist_mix(sum);
+}
+
+/*
+ * Second check on a hit, independent of the hash. The queen locations take the low 32 bits, the stacks the high 32
+ *  bits as a sum of a mix of every covered tile with its height, so stacks with the same tiles in another order differ.
+ * Locations are relative to the hive like the hash, so translated boards still match.
+ */
+static int64_t tt_sanity(struct board *board) {
+    int light = board->light_queen_position == -1 ? -1
+            : hive_relative_location(board, board->light_queen_position);
+    int dark = board->dark_queen_position == -1 ? -1
+            : hive_relative_location(board, board->dark_queen_position);
+
+    uint32_t stacks = 0;
+    for (int i = 0; i < TILE_STACK_SIZE; i++) {
+        struct tile_stack *ts = &board->stack[i];
+        if (ts->location == -1) continue;
+
+        uint64_t tile = (uint64_t) to_tile_index(ts->type) << 40 | (uint64_t) ts->z << 32
+                        | (uint32_t) hive_relative_location(board, ts->location);
+        stacks += (uint32_t) zobrist_mix(tile);
+    }
+    return (int64_t) ((uint64_t) stacks << 32 | (uint64_t) (uint16_t) dark << 16 | (uint16_t) light);
 }
 
 void tt_store(struct node *node, float score, char flag, int depth, int player) {
@@ -40,15 +216,7 @@ void tt_store(struct node *node, float score, char flag, int depth, int player)
         // Simple depth related replacement scheme.
 //        if (entry->depth > depth) return;
     }
-    unsigned char bit_length = 10;
-    int64_t sanity = ((((node->board->dark_queen_position << bit_length)
-                          | node->board->light_queen_position) << bit_length)
-                        | (node->board->min_x) << 5
-                        | (node->board->min_y) << 5
-                        | (node->board->max_x) << 5
-                        | (node->board->max_y) << 5);
-
-    entry->sanity = sanity;
+    entry->sanity = tt_sanity(node->board);
     entry->lock = node->board->zobrist_hash / TT_TABLE_SIZE;
     entry->score = score;
     entry->flag = flag;
@@ -60,21 +228,21 @@ struct tt_entry *tt_retrieve(struct node *node, int player) {
     struct tt_entry *entry = &tt_table[idx];
     int64_t lock = node->board->zobrist_hash / TT_TABLE_SIZE;
 
-    unsigned char bit_length = 10;
-    int64_t sanity = ((((node->board->dark_queen_position << bit_length)
-                          | node->board->light_queen_position) << bit_length)
-                        | (node->board->min_x) << 5
-                        | (node->board->min_y) << 5
-                        | (node->board->max_x) << 5
-                        | (node->board->max_y) << 5);
-    if (entry->flag == -1 || entry->lock != lock || entry->sanity != sanity) return NULL;
+    if (entry->flag == -1 || entry->lock != lock || entry->sanity != tt_sanity(node->board)) return NULL;
 
     return entry;
 }
 
 void tt_init() {
     tt_table = malloc(TT_TABLE_SIZE * 2 * sizeof(struct tt_entry));
-    for (int i = 0; i < TT_TABLE_SIZE; i++) {
+    tt_clear();
+}
+
+/*
+ * Empties the table of both players (set flag to -1 to know if its empty).
+ */
+void tt_clear() {
+    for (int i = 0; i < TT_TABLE_SIZE * 2; i++) {
         tt_table[i].flag = -1;
     }
 }
\ No newline at end of file
@@ -25,7 +25,11 @@ struct tt_entry {
 
 extern int64_t* zobrist_table;
 void zobrist_init();
-void zobrist_hash(struct board* board, int location, int old_location, int type);
+void zobrist_hash(struct board* board, int location, int old_location, int type, int height, int old_height);
+void zobrist_translate(struct board* board, int from, int to);
+void zobrist_rebase(struct board* board);
+void hash_board(struct board* board);
+int64_t zobrist_canonical(struct board* board);
 
 
 //#define TT_TABLE_SIZE (1024*1024*256)
@@ -34,6 +38,7 @@ void zobrist_hash(struct board* board, int location, int old_location, int type)
 extern struct tt_entry* tt_table;
 
 void tt_init();
+void tt_clear();
 void tt_store(struct node* node, float score, char flag, int depth, int player);
 struct tt_entry* tt_retrieve(struct node* node, int player);
 
@@ -62,11 +62,11 @@ int performance_testing_parallel(struct node *tree, int depth, int par_depth) {
 }
 
 
-struct node *random_moves(struct node *node, int n_moves) {
+struct node *random_moves(struct node *node, int n_moves, struct rng *rng) {
     for (int i = 0; i < n_moves; i++) {
         generate_children(node, (time_t) INT_MAX, 0);
 
-        int choice = rand() % node->board->n_children;
+        int choice = (int) rng_below(rng, node->board->n_children);
         struct list *head;
         struct node *child = NULL;
         int n = 0;
@@ -87,12 +87,21 @@ struct node *random_moves(struct node *node, int n_moves) {
     return node;
 }
 
+/*
+ * Seeds the generator of a search from the seed of the player, or from the one of the process if it has none.
+ * The position is mixed in, so every search of a game makes different choices, yet the same ones in every run.
+ */
+void search_rng_seed(struct rng *rng, struct player_arguments *args, struct board *board) {
+    uint64_t seed = args->seed != 0 ? args->seed : game_seed;
+    rng_seed(rng, seed ^ (uint64_t) board->zobrist_hash ^ ((uint64_t) board->turn << 48));
+}
+
 
 void parse_args(int argc, char *const *argv, struct arguments *arguments) {
     int c;
     int errflg = 0;
     struct player_arguments *pa;
-    while ((c = getopt(argc, argv, ":A:a:C:c:t:T:e:E:PpFfvm:q:u:d:")) != -1) {
+    while ((c = getopt(argc, argv, ":A:a:C:c:t:T:e:E:PpFfSsL:l:NnWwR:r:K:k:XxG:g:vm:q:u:d:")) != -1) {
         if (c >= 97) {
             pa = &arguments->p2;
             c -= 32;
@@ -145,6 +154,30 @@ void parse_args(int argc, char *const *argv, struct arguments *arguments) {
             case 'F':
                 pa->first_play_urgency = true;
                 break;
+            case 'S':
+                pa->mcts_solver = true;
+                break;
+            case 'L':
+                pa->solver_depth = atoi(optarg);
+                break;
+            case 'N':
+                pa->pvs = true;
+                break;
+            case 'W':
+                pa->aspiration = true;
+                break;
+            case 'R':
+                pa->playout_length = atoi(optarg);
+                break;
+            case 'K':
+                pa->playout_surround = atoi(optarg);
+                break;
+            case 'X':
+                pa->playout_evaluation = true;
+                break;
+            case 'G':
+                pa->seed = strtoull(optarg, NULL, 10);
+                break;
             case ':':       /* -f or -o without operand */
                 fprintf(stderr,
                         "Option -%c requires an operand\n", optopt);
@@ -178,8 +211,19 @@ void print_args(struct arguments *arguments) {
                "\tMCTS Constant: %.2f\n"
                "\tTime-to-move: %.2f\n"
                "\tMCTS-Prioritization: %d\n"
-               "\tMCTS-FirstPlayUrgency: %d\n", i + 1, algo, eval, pa->mcts_constant, pa->time_to_move,
+               "\tMCTS-FirstPlayUrgency: %d\n"
+               "\tMCTS-Solver: %d (leaf depth %d)\n"
+               "\tMinimax-PVS: %d\n"
+               "\tMinimax-Aspiration: %d\n"
+               "\tMCTS-Playout cutoff: %d plies, surround %d, evaluation %d\n"
+               "\tSeed: %llu\n", i + 1, algo, eval, pa->mcts_constant,
+               pa->time_to_move,
                pa->prioritization,
-               pa->first_play_urgency);
+               pa->first_play_urgency,
+               pa->mcts_solver, pa->solver_depth,
+               pa->pvs,
+               pa->aspiration,
+               pa->playout_length, pa->playout_surround, pa->playout_evaluation,
+               pa->seed);
     }
 }
@@ -6,6 +6,7 @@
 #define HIVE_UTILS_H
 
 #include "node.h"
+#include "random.h"
 #include "../mm/evaluation.h"
 
 #define uchar unsigned char
@@ -21,6 +22,8 @@
                        ((in) == EVAL_DISTANCE ? "Distance" : \
                        ((in) == EVAL_VARIABLE ? "Variable" : "Unknown")))
 
+struct hash_history;
+
 struct player_arguments {
     int algorithm;
     double mcts_constant;
@@ -29,6 +32,20 @@ struct player_arguments {
     bool first_play_urgency;
     bool verbose;
     int evaluation_function;
+    bool mcts_solver;
+    int solver_depth;
+    bool pvs;
+    bool aspiration;
+    // MCTS playouts are cut off after this many plies (0 plays until the turn limit), and then adjudicated.
+    int playout_length;
+    // A playout is decided as soon as one queen has this many more neighbours than the other, 0 disables it.
+    int playout_surround;
+    // Cut off playouts are decided by the sign of the evaluation function instead of the queen neighbours.
+    bool playout_evaluation;
+    // Seed of the random choices of the searches, 0 takes the random seed of the process.
+    unsigned long long seed;
+    // Positions played in the game up to the root, or NULL. Without it, only repetitions below the root are seen.
+    struct hash_history *history;
 };
 struct arguments {
     struct player_arguments p1;
@@ -41,6 +58,7 @@ void print_args(struct arguments *arguments);
 
 int performance_testing(struct node *tree, int depth);
 int performance_testing_parallel(struct node* tree, int depth, int par_depth);
-struct node * random_moves(struct node *tree, int n_moves);
+struct node * random_moves(struct node *tree, int n_moves, struct rng *rng);
+void search_rng_seed(struct rng *rng, struct player_arguments *args, struct board *board);
 
 #endif //HIVE_UTILS_H
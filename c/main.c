@@ -116,18 +116,22 @@ void ptest(struct node *tree) {
 
  *
  */
-void mcts_test(struct node *tree) {
+void mcts_test(struct node *tree, struct player_arguments *args) {
     struct mcts_data *data = tree->data;
     data->keep = true;
 
-    time_t t = time(NULL) + 100000;
+    struct mcts_search search;
+    search.args = args;
+    search.end_time = time(NULL) + 100000;
+    history_start(&search.history, NULL, tree->board);
+    search_rng_seed(&search.rng, args, tree->board);
 
     struct timespec start, end;
     clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
 
     int w = 0, l = 0, d = 0;
     for (int i = 0; i < 1000; i++) {
-        int result = mcts_playout_prio(tree, t);
+        int result = mcts_playout_prio(&search, tree);
         if (result == 1) w++;
         else if (result == 2) l++;
         else if (result == 3) d++;
@@ -163,7 +167,7 @@ int main(int argc, char **argv) {
 
     assert(tree->board != NULL);
 
-//    setup_puzzle(&tree, 4);
+//    setup_puzzle(&tree, "puzzles.txt", "4");
 //    print_board(tree->board);
 //    exit(0);
 
@@ -175,7 +179,7 @@ int main(int argc, char **argv) {
 //        random_moves(&tree, 1);
 //    }
 
-//    mcts_test(tree);
+//    mcts_test(tree, &arguments.p1);
 //
 //    exit(1);
 
@@ -183,6 +187,11 @@ int main(int argc, char **argv) {
 
     omp_set_num_threads(1);
 
+    // The positions played in this game, which the searches continue from.
+    struct hash_history history;
+    history_start(&history, NULL, tree->board);
+    arguments.p1.history = arguments.p2.history = &history;
+
     struct timespec start, end;
     clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
     for (int i = 0; i < n_moves; i++) {
@@ -196,7 +205,9 @@ int main(int argc, char **argv) {
         } else if (pa->algorithm == ALG_MM) {
             child = minimax(tree, pa);
         } else if (pa->algorithm == ALG_RANDOM) {
-            child = random_moves(tree, 1);
+            struct rng rng;
+            search_rng_seed(&rng, pa, tree->board);
+            child = random_moves(tree, 1, &rng);
         } else if (pa->algorithm == ALG_MANUAL) {
             child = manual(tree);
         } else {
@@ -208,6 +219,7 @@ int main(int argc, char **argv) {
         list_remove(&child->node);
         node_free(tree);
         tree = child;
+        history_push(&history, tree->board);
 
         if (pa->verbose)
             print_board(tree->board);
@@ -218,6 +230,12 @@ int main(int argc, char **argv) {
             printf("Player %d won in move %d\n", won, tree->board->turn);
             break;
         }
+        // The same position for the third time.
+        if (history_repetitions(&history) >= 2) {
+            print_board(tree->board);
+            printf("Draw by repetition in move %d\n", tree->board->turn);
+            break;
+        }
     }
 
     clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
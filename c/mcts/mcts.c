@@ -13,6 +13,7 @@
 #include <limits.h>
 #include "mcts.h"
 #include "../mm/evaluation.h"
+#include "../pns/dfpn.h"
 
 
 
@@ -60,15 +61,44 @@ float prioritization(struct node* node) {
 }
 
 
-float expensive_prioritization(struct node *node) {
+/*
+ * Static evaluation used by the first play urgency, positive values are good for light.
+ */
+float prioritization_score(struct node *node) {
     // We want to have this information.
     update_can_move(node->board, node->move.location, node->move.previous_location);
 
+    struct board *board = node->board;
+    float value = unused_tiles(node) * 0.3f;
+    for (int i = 0; i < N_TILES * 2; i++) {
+        if (!tile_on_top(board, i)) continue;
+
+        int location = board->tile_locations[i];
+        unsigned char tile = board->tiles[location];
+        if (!tile_free(board, location)) {
+            float inc = 1.f;
+            if ((tile & TILE_MASK) == L_ANT) {
+                inc = 2.f;
+            }
+            if ((tile & COLOR_MASK) == LIGHT) {
+                value -= inc;
+            } else {
+                value += inc;
+            }
+        }
+    }
 
+    // Tiles around the queen of player 1 lower the value, tiles around the queen of player 2 raise it.
+    value += ((float) board->eval.queen_neighbours[1] - (float) board->eval.queen_neighbours[0]) * 10.0f;
+    return value;
+}
+
+
+float expensive_prioritization(struct node *node, struct rng *rng) {
 #ifdef TESTING
     float value = 0.;
 #else
-    float value = 0.f + (float) (rand() % 100) / 1000.f;
+    float value = 0.f + (float) rng_below(rng, 100) / 1000.f;
 #endif
 
     int won = finished_board(node->board);
@@ -79,63 +109,12 @@ float expensive_prioritization(struct node *node) {
     } else if (won == 3) {
         value = 0;
     } else {
-        value += unused_tiles(node) * 0.3f;
-
-        int n_encountered = 0;
-        int to_encounter = sum_hive_tiles(node->board);
-
-#ifdef CENTERED
-        struct board *board = node->board;
-        int ly = board->min_y, hy = board->max_y + 1;
-        int lx = board->min_x, hx = board->max_x + 1;
-#else
-        int ly = 0, hy = BOARD_SIZE;
-        int lx = 0, hx = BOARD_SIZE;
-#endif
-
-        for (int x = lx; x < hx; x++) {
-            if (n_encountered == to_encounter) break;
-            for (int y = ly; y < hy; y++) {
-                if (n_encountered == to_encounter) break;
-                unsigned char tile = node->board->tiles[y * BOARD_SIZE + x];
-                if (tile == EMPTY) continue;
-                n_encountered++;
-
-                if (!node->board->free[y * BOARD_SIZE + x]) {
-                    float inc = 1.f;
-                    if ((tile & TILE_MASK) == L_ANT) {
-                        inc = 2.f;
-                    }
-                    if ((tile & COLOR_MASK) == LIGHT) {
-                        value -= inc;
-                    } else {
-                        value += inc;
-                    }
-                }
-            }
-        }
-
-        if (node->board->light_queen_position != -1) {
-            int x1 = node->board->light_queen_position % BOARD_SIZE;
-            int y1 = node->board->light_queen_position / BOARD_SIZE;
-            int *points = get_points_around(y1, x1);
-            for (int i = 0; i < 6; i++) {
-                // If there is a tile around the queen of player 1, the value drops by 1
-                if (node->board->tiles[points[i]] != EMPTY)
-                    value -= 10.0f;
-            }
-        }
-
-        if (node->board->dark_queen_position != -1) {
-            int x2 = node->board->dark_queen_position % BOARD_SIZE;
-            int y2 = node->board->dark_queen_position / BOARD_SIZE;
-            int *points = get_points_around(y2, x2);
-            for (int i = 0; i < 6; i++) {
-                // If there is a tile around the queen of player 2, the value increases by 1
-                if (node->board->tiles[points[i]] != EMPTY)
-                    value += 10.0f;
-            }
+        float score;
+        if (!eval_cache_probe(node->board, EVAL_PRIORITIZATION, &score)) {
+            score = prioritization_score(node);
+            eval_cache_store(node->board, EVAL_PRIORITIZATION, score);
         }
+        value += score;
     }
 
     int player = node->board->turn % 2;
@@ -161,6 +140,8 @@ struct node *mcts_init() {
     data->value = 0.;
     data->n_sims = 0;
     data->keep = false;
+    data->solved = 0;
+    data->solved_plies = 0;
 
     node_init(root, (void *) data);
     return root;
@@ -176,12 +157,53 @@ struct node *mcts_add_child(struct node *node, struct board *board) {
 
 void print_mcts_data(struct mcts_data *pData);
 
-int mcts_playout(struct node *root, double end_time) {
+/*
+ * Decides a playout which is cut off before the game is finished, with the results of finished_board.
+ * The player whose queen has fewer neighbours wins, or with playout_evaluation the player favoured by the evaluation.
+ */
+static int mcts_adjudicate(struct node *node, struct player_arguments *args) {
+    float score;
+    if (args->playout_evaluation) {
+        score = evaluation_score(node, args->evaluation_function);
+    } else {
+        score = (float) node->board->eval.queen_neighbours[1] - (float) node->board->eval.queen_neighbours[0];
+    }
+
+    if (score > 0) return 1;
+    if (score < 0) return 2;
+    return 3;
+}
+
+/*
+ * Returns the result of a playout which has played the given amount of plies if it is cut off here, 0 otherwise.
+ * With playout_surround the player whose queen has that many more neighbours than the other loses right away.
+ */
+static int mcts_cutoff(struct node *node, int length, struct player_arguments *args) {
+    if (args->playout_surround > 0) {
+        int difference = node->board->eval.queen_neighbours[1] - node->board->eval.queen_neighbours[0];
+        if (difference >= args->playout_surround) return 1;
+        if (-difference >= args->playout_surround) return 2;
+    }
+
+    if (args->playout_length > 0 && length >= args->playout_length) return mcts_adjudicate(node, args);
+    return 0;
+}
+
+/*
+ * Plays random moves from the root until the game is finished or the playout is cut off, the history of the search
+ *  holds the positions up to the root.
+ * Returning to an earlier position is a draw, shuffling tiles back and forth would otherwise last until the turn limit.
+ */
+int mcts_playout(struct mcts_search *search, struct node *root) {
+    struct player_arguments *args = search->args;
     struct node *node = root;
-    while (true) {
+    for (int length = 0; true; length++) {
         struct mcts_data *parent_data = node->data;
 
+        history_push(&search->history, node->board);
         int won = finished_board(node->board);
+        if (won == 0 && history_repetitions(&search->history) > 0) won = 3;
+        if (won == 0) won = mcts_cutoff(node, length, args);
         if (won > 0) {
             if (!parent_data->keep) {
                 // Done using the previous node completely
@@ -191,31 +213,23 @@ int mcts_playout(struct node *root, double end_time) {
         }
 
         // Draw if no children could be generated due to time/mem constraints
-        int generated_children = generate_children(node, end_time, 0);
+        int generated_children = generate_children(node, search->end_time, 0);
         if (generated_children != 0) {
+            // With a playout length the turn limit is just another cutoff.
+            if (generated_children == ERR_NOMOVES && args->playout_length > 0) won = mcts_adjudicate(node, args);
+            else if (generated_children == ERR_NOMEM) won = 5;
+            else won = 4;
+
             if (!parent_data->keep) {
                 // Done using the previous node completely
                 node_free(node);
             }
-            if (generated_children == ERR_NOMEM) {
-                return 5;
-            }
-            return 4;
-
-            // This is to force draws to not exist anymore.
-            int dc = count_tiles_around(node->board, node->board->dark_queen_position);
-            int lc = count_tiles_around(node->board, node->board->light_queen_position);
-
-            if (dc > lc) {
-                return 1;
-            } else {
-                return 2;
-            }
+            return won;
         }
 
         struct list *head, *temp;
         // Select random move to play MC(TS).
-        int random_choice = rand() % node->board->n_children;
+        int random_choice = (int) rng_below(&search->rng, node->board->n_children);
 
         int n = 0;
         node_foreach_safe(node, head, temp) {
@@ -237,15 +251,20 @@ int mcts_playout(struct node *root, double end_time) {
     }
 }
 
-int mcts_playout_prio(struct node *root, double end_time) {
+int mcts_playout_prio(struct mcts_search *search, struct node *root) {
+    struct player_arguments *args = search->args;
     struct node *node = root;
-    while (true) {
+    for (int length = 0; true; length++) {
+        history_push(&search->history, node->board);
         int won = finished_board(node->board);
+        if (won == 0 && history_repetitions(&search->history) > 0) won = 3;
+        if (won == 0) won = mcts_cutoff(node, length, args);
         if (won > 0) return won;
 
         // Draw if no children could be generated due to time constraints
-        int generated_children = generate_children(node, end_time, 0);
+        int generated_children = generate_children(node, search->end_time, 0);
         if (generated_children != 0) {
+            if (generated_children == ERR_NOMOVES && args->playout_length > 0) return mcts_adjudicate(node, args);
             if (generated_children == ERR_NOMEM) return 4;
             return 3;
         }
@@ -258,7 +277,7 @@ int mcts_playout_prio(struct node *root, double end_time) {
             child_data->prio = prioritization(child);
             prio_sum += child_data->prio;
         }
-        float random_choice = ((float) rand() / INT_MAX) * prio_sum;
+        float random_choice = rng_float(&search->rng) * prio_sum;
         struct mcts_data *parent_data = node->data;
         node_foreach_safe(node, head, temp) {
             struct node *child = container_of(head, struct node, node);
@@ -280,11 +299,17 @@ int mcts_playout_prio(struct node *root, double end_time) {
 }
 
 
-struct node* mcts_select_leaf(struct node* root, struct player_arguments* args) {
+/*
+ * Descends from the root to a leaf, and pushes the positions on the way on the history.
+ */
+struct node* mcts_select_leaf(struct mcts_search* search, struct node* root) {
+    struct player_arguments* args = search->args;
     struct node* mcts_leaf = root;
     struct list* head;
 
     while (!list_empty(&mcts_leaf->children)) {
+        history_push(&search->history, mcts_leaf->board);
+
         struct node *best = NULL;
         double best_value = -INFINITY;
 
@@ -303,9 +328,12 @@ struct node* mcts_select_leaf(struct node* root, struct player_arguments* args)
             struct node *child = container_of(head, struct node, node);
             struct mcts_data *data = child->data;
 
+            // Proven children need no more simulations.
+            if (data->solved != 0) continue;
+
             // First play urgency only when all nodes have no simulations done on them.
             if (first_play_urgency_active) {
-                double value = expensive_prioritization(child);
+                double value = expensive_prioritization(child, &search->rng);
                 if (best_value < value) {
                     best_value = value;
                     best = child;
@@ -347,8 +375,43 @@ struct node* mcts_select_leaf(struct node* root, struct player_arguments* args)
 }
 
 
+/*
+ * Returns the proven result of a node from its children, or 0 if it cannot be proven yet.
+ * A node is won as soon as one move wins for the player to move, otherwise all moves have to be proven.
+ * The plies are set to the most the result can take; the quickest win, or the slowest of all moves otherwise.
+ */
+int mcts_solve(struct node *node, short *plies) {
+    int win = node->board->turn % 2 == 0 ? 1 : 2;
+    bool unknown = false, draw = false;
+    short fastest_win = SHRT_MAX, slowest = 0;
+
+    struct list *head;
+    node_foreach(node, head) {
+        struct mcts_data *data = container_of(head, struct node, node)->data;
+        if (data->solved == win) fastest_win = MIN(fastest_win, data->solved_plies);
+
+        if (data->solved == 0) unknown = true;
+        else if (data->solved == 3) draw = true;
+        slowest = MAX(slowest, data->solved_plies);
+    }
+    if (fastest_win != SHRT_MAX) {
+        *plies = (short) (fastest_win + 1);
+        return win;
+    }
+    if (unknown) return 0;
+
+    *plies = (short) (slowest + 1);
+    if (draw) return 3;
+    return win == 1 ? 2 : 1;
+}
+
+/*
+ * Adds the playout result to all nodes up to the root. If the leaf is proven, its parents are proven as
+ *  far as possible, which works like backing up an infinite value.
+ */
 void mcts_cascade_result(struct node* root, struct node* leaf, double value) {
     struct node* node = leaf;
+    int solved = ((struct mcts_data *) leaf->data)->solved;
 
     while (1) {
         struct mcts_data* data = node->data;
@@ -363,6 +426,46 @@ void mcts_cascade_result(struct node* root, struct node* leaf, double value) {
 
         // Get parent of this node.
         node = container_of(node->node.head, struct node, children);
+
+        if (solved != 0) {
+            struct mcts_data *parent_data = node->data;
+            solved = mcts_solve(node, &parent_data->solved_plies);
+            parent_data->solved = solved;
+        }
+    }
+}
+
+/*
+ * Returns true if either queen is close to being surrounded.
+ */
+bool mcts_near_surround(struct board *board) {
+    int queens[2] = {board->light_queen_position, board->dark_queen_position};
+    for (int i = 0; i < 2; i++) {
+        if (queens[i] != -1 && count_tiles_around(board, queens[i]) >= MCTS_SOLVER_SURROUND)
+            return true;
+    }
+    return false;
+}
+
+/*
+ * Proves a new leaf if it is finished, or if the bounded df-pn search finds a win for the player to move.
+ * The df-pn search only looks as deep as the solver depth reaches below the root, which is the leaf depth plies above.
+ */
+void mcts_solve_leaf(struct node *leaf, int leaf_depth, struct player_arguments *args, double end_time) {
+    struct mcts_data *data = leaf->data;
+    data->solved = finished_board(leaf->board);
+    data->solved_plies = 0;
+    int max_depth = args->solver_depth - leaf_depth;
+    if (data->solved != 0 || max_depth <= 0 || !mcts_near_surround(leaf->board)) return;
+
+    struct timespec cur_time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cur_time);
+    double solver_end_time = MIN(to_usec(cur_time) / 1e6 + MCTS_SOLVER_TIME, end_time);
+
+    // A win of the player to move takes an odd amount of plies, deepening over those finds the quickest one.
+    for (int depth = 1; depth <= max_depth && data->solved == 0; depth += 2) {
+        data->solved = dfpn_solve(leaf->board, solver_end_time, depth);
+        data->solved_plies = (short) depth;
     }
 }
 
@@ -377,12 +480,20 @@ void mcts_prepare(struct node* root, struct player_arguments* args) {
         parent_data->value = 0;
         parent_data->n_sims = 0;
         parent_data->keep = true;
+        parent_data->solved = 0;
+        parent_data->solved_plies = 0;
         root->data = parent_data;
     } else {
         parent_data = root->data;
         parent_data->keep = true;
+        // The children are generated again, so they have to be proven again as well.
+        parent_data->solved = 0;
+        parent_data->solved_plies = 0;
     }
 
+    eval_cache_prepare();
+    eval_cache_probes = eval_cache_hits = 0;
+
     // Register mcts node add function
     dedicated_add_child = mcts_add_child;
     dedicated_init = mcts_init;
@@ -403,29 +514,43 @@ struct node* mcts(struct node *root, struct player_arguments *args) {
 
     generate_children(root, end_time, 0);
 
+    struct mcts_search search;
+    search.args = args;
+    search.end_time = end_time;
+    history_start(&search.history, args->history, root->board);
+    search_rng_seed(&search.rng, args, root->board);
+
     int n_iterations = 0;
 
     // Generate random branches until time runs out
     while (true) {
         clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cur_time);
         double now = (to_usec(cur_time) / 1e6);
-        if (now > end_time) break;
+        if (now > end_time || expansion_budget_spent()) break;
+
+        // Stop as soon as the outcome is known.
+        if (((struct mcts_data *) root->data)->solved != 0) break;
 
         n_iterations++;
 
         // Select a leaf based on MCTS rules.
-        struct node* mcts_leaf = mcts_select_leaf(root, args);
+        struct node* mcts_leaf = mcts_select_leaf(&search, root);
         struct mcts_data* data = mcts_leaf->data;
 
         // Keep the node until data cascaded
         data->keep = true;
 
+        if (args->mcts_solver && data->n_sims == 0 && mcts_leaf != root)
+            mcts_solve_leaf(mcts_leaf, mcts_leaf->board->turn - root->board->turn, args, end_time);
+
         int win;
         // Argument for prioritization
-        if (args->prioritization) {
-            win = mcts_playout_prio(mcts_leaf, end_time);
+        if (data->solved != 0) {
+            win = data->solved;
+        } else if (args->prioritization) {
+            win = mcts_playout_prio(&search, mcts_leaf);
         } else {
-            win = mcts_playout(mcts_leaf, end_time);
+            win = mcts_playout(&search, mcts_leaf);
         }
         if (win == 5) {
             printf("Early memory termination.\n");
@@ -447,6 +572,8 @@ struct node* mcts(struct node *root, struct player_arguments *args) {
     }
     if (args->verbose)
         printf("Generated samples/s: %.2f\n", (n_iterations / args->time_to_move));
+    if (args->verbose && args->first_play_urgency)
+        printf("Evaluation cache hits: %.1f%% (%llu probes)\n", eval_cache_hit_rate(), eval_cache_probes);
 
 
 #ifdef DEBUG
@@ -459,15 +586,23 @@ struct node* mcts(struct node *root, struct player_arguments *args) {
     double best_ratio = 0.0;
     struct node *best = NULL;
 
+    int win = root->board->turn % 2 == 0 ? 1 : 2;
+    int root_solved = ((struct mcts_data *) root->data)->solved;
+
     node_foreach(root, head) {
         struct node *child = container_of(head, struct node, node);
         struct mcts_data *data = child->data;
 
         double value = root->board->turn % 2 == 0 ? data->value : data->n_sims - data->value;
         double ratio = value / data->n_sims;
-        char* mve = string_move(child);
-        printf("%.2f/%d = %.2f for %s\n", data->value, data->n_sims, ratio, mve);
-        free(mve);
+        // Proven wins are always taken, proven losses only if every move loses.
+        if (data->solved == win) ratio = INFINITY;
+        else if (data->solved != 0 && data->solved != 3 && root_solved != data->solved) continue;
+        if (args->verbose) {
+            char *mve = string_move(child);
+            printf("%.2f/%d = %.2f for %s\n", data->value, data->n_sims, ratio, mve);
+            free(mve);
+        }
         if (ratio > best_ratio) {
 #ifdef DEBUG
             printf("%d/%d/%d\n", data->p0, data->p1, data->draw);
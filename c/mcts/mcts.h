@@ -7,13 +7,35 @@
 
 #include <time.h>
 #include <stdbool.h>
+#include "board.h"
 #include "utils.h"
+#include "random.h"
+
+// Leaves with a queen that has at least this many neighbours are searched by the df-pn solver.
+#define MCTS_SOLVER_SURROUND 4
+// Cpu time in seconds the df-pn solver may spend on a single leaf.
+#define MCTS_SOLVER_TIME 0.005
 
 struct mcts_data {
     double value;
     uint n_sims;
     bool keep;
     float prio;
+    // Proven result (as returned by finished_board) of this node, 0 while it is unknown.
+    int solved;
+    // The proven result is reached within this many plies at most.
+    short solved_plies;
+};
+
+/*
+ * State of a single search, its playouts draw their moves from its own generator.
+ */
+struct mcts_search {
+    struct player_arguments *args;
+    double end_time;
+    // Positions of the game up to the root, and of the path to the current leaf and its playout on top.
+    struct hash_history history;
+    struct rng rng;
 };
 
 struct node *mcts_init();
@@ -22,7 +44,7 @@ struct node *mcts_add_child(struct node *node, struct board *board);
 
 
 struct node* mcts(struct node *tree, struct player_arguments *args);
-int mcts_playout(struct node *root, double end_time);
-int mcts_playout_prio(struct node *root, double end_time);
+int mcts_playout(struct mcts_search *search, struct node *root);
+int mcts_playout_prio(struct mcts_search *search, struct node *root);
 
 #endif //HIVE_MCTS_H
@@ -3,9 +3,11 @@
 //
 
 #include <stdlib.h>
+#include <string.h>
 #include <board.h>
 #include <stdio.h>
 #include <math.h>
+#include "evaluation.h"
 
 #ifndef MOVEMENT_REST
 #define MOVEMENT_REST 7.28f
@@ -18,13 +20,19 @@
 #endif
 
 // Global defines.
+// The variable evaluation ignores the distance to the queens unless it is set with -D.
 struct eval_multi evaluation_multipliers = {
         .movement = 7.28f,
         .queen = 3.25f,
         .used_tiles = 9.5f,
-        .distance_to_queen = 1.0f
+        .distance_to_queen = 0.0f
 };
-bool (*mm_evaluate)(struct node*);
+bool (*mm_evaluate)(struct node*, struct rng*);
+
+struct eval_cache_entry* eval_cache = NULL;
+unsigned long long eval_cache_probes = 0, eval_cache_hits = 0;
+// The multipliers the scores of the variable evaluation in the cache were computed with.
+static struct eval_multi eval_cache_multipliers;
 
 struct eval_multi dtq_multipliers = {
         .movement = 0.25f,
@@ -33,6 +41,86 @@ struct eval_multi dtq_multipliers = {
         .distance_to_queen = 5.32f
 };
 
+struct eval_multi expqueen_multipliers = {
+        .movement = 8.493793292308318f,
+        .queen = 0.05295699310799809f,
+        .used_tiles = 8.87622930462319f,
+        .distance_to_queen = 0.0f
+};
+
+
+void eval_cache_init() {
+    eval_cache = malloc(EVAL_CACHE_SIZE * sizeof(struct eval_cache_entry));
+    if (eval_cache == NULL) {
+        fprintf(stderr, "No memory left to allocate the evaluation cache\n");
+        exit(1);
+    }
+    eval_cache_clear();
+}
+
+/*
+ * Empties the cache if it was allocated, so a search does not see the evaluations of another.
+ */
+void eval_cache_clear() {
+    if (eval_cache == NULL) return;
+
+    // A zero check with a zero score would match the empty board, so empty entries get a check of 1.
+    for (int i = 0; i < EVAL_CACHE_SIZE; i++) {
+        eval_cache[i].check = 1;
+        eval_cache[i].bits = 0;
+    }
+}
+
+/*
+ * Allocates the cache before a search, and empties it if the evaluation multipliers changed since it was filled, as
+ *  the scores of the variable evaluation depend on them and its keys do not.
+ */
+void eval_cache_prepare() {
+    if (eval_cache == NULL) {
+        eval_cache_init();
+    } else if (memcmp(&eval_cache_multipliers, &evaluation_multipliers, sizeof(struct eval_multi)) != 0) {
+        eval_cache_clear();
+    }
+    eval_cache_multipliers = evaluation_multipliers;
+}
+
+/*
+ * Every evaluation function gets its own keys, so their scores never mix.
+ */
+static inline int64_t eval_cache_key(struct board* board, int function) {
+    return board->zobrist_hash ^ ((int64_t) function * 0x9e3779b97f4a7c15ll);
+}
+
+bool eval_cache_probe(struct board* board, int function, float* score) {
+    int64_t key = eval_cache_key(board, function);
+    struct eval_cache_entry* entry = &eval_cache[(uint64_t) key % EVAL_CACHE_SIZE];
+    struct eval_cache_entry copy = *entry;
+
+#pragma omp atomic
+    eval_cache_probes++;
+    if ((copy.check ^ copy.bits) != key) return false;
+
+#pragma omp atomic
+    eval_cache_hits++;
+    *score = copy.score;
+    return true;
+}
+
+void eval_cache_store(struct board* board, int function, float score) {
+    int64_t key = eval_cache_key(board, function);
+    struct eval_cache_entry* entry = &eval_cache[(uint64_t) key % EVAL_CACHE_SIZE];
+
+    entry->score = score;
+    entry->check = key ^ entry->bits;
+}
+
+/*
+ * Percentage of the probes since the counters were last reset that found their score.
+ */
+float eval_cache_hit_rate() {
+    if (eval_cache_probes == 0) return 0.f;
+    return 100.f * (float) eval_cache_hits / (float) eval_cache_probes;
+}
 
 float unused_tiles(struct node* node) {
     float value = 0;
@@ -57,239 +145,104 @@ float mvt(unsigned char tile) {
 }
 
 
-bool mm_evaluate_expqueen(struct node* node) {
-    struct mm_data* data = node->data;
-
-    // We want to have this information.
-    update_can_move(node->board, node->move.location, node->move.previous_location);
-
-
-#ifdef TESTING
-    float value = 0.;
+/*
+ * Sum of the squared distances of all tiles on top of the given colour to the position.
+ * Expanding (ax - x)^2 + (ay - y)^2 over the tiles only needs the tile moments of the board.
+ */
+float distance_to_queen(struct board *board, int position, int color) {
+    struct eval_state* eval = &board->eval;
+    int c = color >> COLOR_SHIFT;
+#ifdef TORUS
+    // The moments are relative to the start of the hive, see eval_track_tile.
+    int ax = hive_offset(position % BOARD_SIZE, board->min_x);
+    int ay = hive_offset(position / BOARD_SIZE, board->min_y);
 #else
-    float value = 0.f + (float)(rand() % 100) / 1000.f;
+    int ax = position % BOARD_SIZE;
+    int ay = position / BOARD_SIZE;
 #endif
+    return (float) (eval->n_top[c] * (ax * ax + ay * ay)
+                    - 2 * (ax * eval->sum_x[c] + ay * eval->sum_y[c])
+                    + eval->sum_squares[c]);
+}
 
-    int won = finished_board(node->board);
-    if (won == 1) {
-        data->mm_value = MM_INFINITY - (float)node->board->turn;
-        return true;
-    } if (won == 2) {
-        data->mm_value = -MM_INFINITY + (float)node->board->turn;
-        return true;
-    } if (won == 3) {
-        data->mm_value = 0;
-        return true;
-    }
-
-    value += unused_tiles(node) * 8.87622930462319f;
-
-    int n_encountered = 0;
-    int to_encounter = sum_hive_tiles(node->board);
 
-#ifdef CENTERED
+/*
+ * Fills the features of the board from its incrementally updated evaluation state, positive values are good for
+ *  the light player. Immobile tiles are weighted by their type when weighted is set.
+ */
+void evaluation_features(struct node* node, bool weighted, struct eval_multi* features) {
     struct board* board = node->board;
-    int ly = board->min_y, hy = board->max_y + 1;
-    int lx = board->min_x, hx = board->max_x + 1;
-#else
-    int ly = 0, hy = BOARD_SIZE;
-    int lx = 0, hx = BOARD_SIZE;
-#endif
-
+    struct eval_state* eval = &board->eval;
 
-    float free_counter = 0.f;
-    for (int x = lx; x < hx; x++) {
-        if (n_encountered == to_encounter) break;
-        for (int y = ly; y < hy; y++) {
-            if (n_encountered == to_encounter) break;
-            unsigned char tile = node->board->tiles[y * BOARD_SIZE + x];
-            if (tile == EMPTY) continue;
-            n_encountered++;
-
-            if (!node->board->free[y * BOARD_SIZE + x]) {
-                float inc = mvt(tile);
-                if ((tile & COLOR_MASK) == LIGHT) {
-                    free_counter -= inc;
-                } else {
-                    free_counter += inc;
-                }
-            }
+    float immobile[2] = {0.f, 0.f};
+    for (int c = 0; c < 2; c++) {
+        for (int t = 0; t < N_UNIQUE_TILES; t++) {
+            immobile[c] += (float) eval->immobile[c][t] * (weighted ? mvt(t + 1) : 1.f);
         }
     }
 
-    // Count the tiles on the stack too.
-    for (int i = 0; i < node->board->n_stacked; i++) {
-        struct tile_stack* ts = &node->board->stack[i];
-        unsigned char tile = ts->type;
-        float inc = mvt(tile);
-        if ((tile & COLOR_MASK) == LIGHT) {
-            free_counter -= inc;
-        } else {
-            free_counter += inc;
-        }
-    }
-
-    float movement_multiplier = 8.493793292308318f;
-    value += free_counter * movement_multiplier;
-
-    if (node->board->light_queen_position != -1) {
-        int x1 = node->board->light_queen_position % BOARD_SIZE;
-        int y1 = node->board->light_queen_position / BOARD_SIZE;
-        int* points = get_points_around(y1, x1);
-        for (int i = 0; i < 6; i++) {
-            // If there is a tile around the queen of player 1, the value drops by 1
-            if (node->board->tiles[points[i]] != EMPTY)
-                value -=  0.05295699310799809f;
-        }
-    }
-
-    if (node->board->dark_queen_position != -1) {
-        int x2 = node->board->dark_queen_position % BOARD_SIZE;
-        int y2 = node->board->dark_queen_position / BOARD_SIZE;
-        int* points = get_points_around(y2, x2);
-        for (int i = 0; i < 6; i++) {
-            // If there is a tile around the queen of player 2, the value increases by 1
-            if (node->board->tiles[points[i]] != EMPTY)
-                value +=  0.05295699310799809f;
-        }
-    }
-
-    data->mm_value = value;
-    return false;
+    features->used_tiles = unused_tiles(node);
+    features->movement = immobile[1] - immobile[0];
+    features->queen = (float) eval->queen_neighbours[1] - (float) eval->queen_neighbours[0];
+    features->distance_to_queen = distance_to_queen(board, board->light_queen_position, DARK)
+                                  - distance_to_queen(board, board->dark_queen_position, LIGHT);
 }
 
-bool mm_evaluate_variable(struct node* node) {
-    struct mm_data* data = node->data;
-
-    // We want to have this information.
-    update_can_move(node->board, node->move.location, node->move.previous_location);
 
-#ifdef TESTING
-    float value = 0.;
-#else
-    float value = 0.f + (float)(rand() % 100) / 1000.f;
-#endif
-
-    int won = finished_board(node->board);
-    if (won == 1) {
-        data->mm_value = MM_INFINITY - (float)node->board->turn;
-        return true;
-    }
-    if (won == 2) {
-        data->mm_value = -MM_INFINITY + (float)node->board->turn;
-        return true;
-    }
-    if (won == 3) {
-        data->mm_value = 0;
-        return true;
-    }
-
-
-    value += unused_tiles(node) * evaluation_multipliers.used_tiles;
-
-    int n_encountered = 0;
-    int to_encounter = sum_hive_tiles(node->board);
-
-#ifdef CENTERED
-    struct board* board = node->board;
-    int ly = board->min_y, hy = board->max_y + 1;
-    int lx = board->min_x, hx = board->max_x + 1;
-#else
-    int ly = 0, hy = BOARD_SIZE;
-    int lx = 0, hx = BOARD_SIZE;
-#endif
-
-    float free_counter = 0.f;
-    for (int x = lx; x < hx; x++) {
-        if (n_encountered == to_encounter) break;
-        for (int y = ly; y < hy; y++) {
-            if (n_encountered == to_encounter) break;
-            uchar tile = node->board->tiles[y * BOARD_SIZE + x];
-            if (tile == EMPTY) continue;
-            n_encountered++;
-
-            if (!node->board->free[y * BOARD_SIZE + x]) {
-                float inc = 1;
-                if ((tile & COLOR_MASK) == LIGHT) {
-                    free_counter -= inc;
-                } else {
-                    free_counter += inc;
-                }
-            }
-        }
-    }
+float evaluation_dot(struct eval_multi* features, struct eval_multi* multipliers) {
+    return features->used_tiles * multipliers->used_tiles
+           + features->movement * multipliers->movement
+           + features->queen * multipliers->queen
+           + features->distance_to_queen * multipliers->distance_to_queen;
+}
 
-    // Count the tiles on the stack too.
-    for (int i = 0; i < node->board->n_stacked; i++) {
-        struct tile_stack* ts = &node->board->stack[i];
-        unsigned char tile = ts->type;
-        float inc = 1;
-        if ((tile & COLOR_MASK) == LIGHT) {
-            free_counter -= inc;
-        } else {
-            free_counter += inc;
-        }
-    }
 
-    value += free_counter * evaluation_multipliers.movement;
-
-    float queen_count = 0;
-    if (node->board->light_queen_position != -1) {
-        int x1 = node->board->light_queen_position % BOARD_SIZE;
-        int y1 = node->board->light_queen_position / BOARD_SIZE;
-        int* points = get_points_around(y1, x1);
-        for (int i = 0; i < 6; i++) {
-            // If there is a tile around the queen of player 1, the value drops by 1
-            if (node->board->tiles[points[i]] != EMPTY)
-                queen_count -= 1;
-        }
-    }
+/*
+ * Dot product of the features of the board with the multipliers, through the evaluation cache.
+ */
+static float evaluation_cached(struct node* node, int function, struct eval_multi* multipliers, bool weighted) {
+    float score;
+    if (!eval_cache_probe(node->board, function, &score)) {
+        // We want to have this information.
+        update_can_move(node->board, node->move.location, node->move.previous_location);
 
-    if (node->board->dark_queen_position != -1) {
-        int x2 = node->board->dark_queen_position % BOARD_SIZE;
-        int y2 = node->board->dark_queen_position / BOARD_SIZE;
-        int* points = get_points_around(y2, x2);
-        for (int i = 0; i < 6; i++) {
-            // If there is a tile around the queen of player 2, the value increases by 1
-            if (node->board->tiles[points[i]] != EMPTY)
-                queen_count += 1;
-        }
+        struct eval_multi features;
+        evaluation_features(node, weighted, &features);
+        score = evaluation_dot(&features, multipliers);
+        eval_cache_store(node->board, function, score);
     }
-    value += queen_count * evaluation_multipliers.queen;
-
-    data->mm_value = value;
-    return false;
+    return score;
 }
 
 
-float distance_to_queen(struct board *board, int position, int color) {
-    float dtq = 0.f;
-    int ax = position % BOARD_SIZE;
-    int ay = position / BOARD_SIZE;
-    for (int y = board->min_y; y < board->max_y; y++) {
-        for (int x = board->min_x; x < board->max_x; x++) {
-            int pos = y * BOARD_SIZE + x;
-            uchar tile_type = board->tiles[pos];
-            if (tile_type == EMPTY || (tile_type & COLOR_MASK) != color) continue;
-
-            int dx = ax - x;
-            int dy = ay - y;
-            dtq += (float)(dx * dx + dy * dy);
-        }
+/*
+ * Score of an unfinished board by one of the evaluation functions, without the noise of mm_evaluate.
+ * Unlike mm_evaluate it does not need mm_data on the node, so MCTS can use it to adjudicate playouts.
+ */
+float evaluation_score(struct node* node, int function) {
+    switch (function) {
+        case EVAL_QUEEN:
+            return evaluation_cached(node, EVAL_QUEEN, &expqueen_multipliers, true);
+        case EVAL_DISTANCE:
+            return evaluation_cached(node, EVAL_DISTANCE, &dtq_multipliers, false);
+        default:
+            return evaluation_cached(node, EVAL_VARIABLE, &evaluation_multipliers, false);
     }
-    return dtq;
 }
 
-bool mm_evaluate_distance(struct node* node) {
-    struct mm_data* data = node->data;
 
-    // We want to have this information.
-    update_can_move(node->board, node->move.location, node->move.previous_location);
+/*
+ * Evaluates a leaf as the dot product of its features with the multipliers, plus a little noise from the generator
+ *  of the search. Returns true if the board is finished, in which case the value is exact.
+ */
+bool mm_evaluate_multipliers(struct node* node, struct rng* rng, int function, struct eval_multi* multipliers,
+                             bool weighted) {
+    struct mm_data* data = node->data;
 
 #ifdef TESTING
     float value = 0.;
 #else
-    float value = 0.f + (float)(rand() % 100) / 1000.f;
+    float value = 0.f + (float) rng_below(rng, 100) / 1000.f;
 #endif
 
     int won = finished_board(node->board);
@@ -306,83 +259,18 @@ bool mm_evaluate_distance(struct node* node) {
         return true;
     }
 
+    data->mm_value = value + evaluation_cached(node, function, multipliers, weighted);
+    return false;
+}
 
-    value += unused_tiles(node) * dtq_multipliers.used_tiles;
-
-    int n_encountered = 0;
-    int to_encounter = sum_hive_tiles(node->board);
-
-#ifdef CENTERED
-    struct board* board = node->board;
-    int ly = board->min_y, hy = board->max_y + 1;
-    int lx = board->min_x, hx = board->max_x + 1;
-#else
-    int ly = 0, hy = BOARD_SIZE;
-    int lx = 0, hx = BOARD_SIZE;
-#endif
-
-    float free_counter = 0.f;
-    for (int x = lx; x < hx; x++) {
-        if (n_encountered == to_encounter) break;
-        for (int y = ly; y < hy; y++) {
-            if (n_encountered == to_encounter) break;
-            uchar tile = node->board->tiles[y * BOARD_SIZE + x];
-            if (tile == EMPTY) continue;
-            n_encountered++;
-
-            if (!node->board->free[y * BOARD_SIZE + x]) {
-                float inc = 1;
-                if ((tile & COLOR_MASK) == LIGHT) {
-                    free_counter -= inc;
-                } else {
-                    free_counter += inc;
-                }
-            }
-        }
-    }
-
-    // Count the tiles on the stack too.
-    for (int i = 0; i < node->board->n_stacked; i++) {
-        struct tile_stack* ts = &node->board->stack[i];
-        unsigned char tile = ts->type;
-        float inc = 1;
-        if ((tile & COLOR_MASK) == LIGHT) {
-            free_counter -= inc;
-        } else {
-            free_counter += inc;
-        }
-    }
-
-    value += free_counter * dtq_multipliers.movement;
-
-    float queen_count = 0;
-    if (node->board->light_queen_position != -1) {
-        int x1 = node->board->light_queen_position % BOARD_SIZE;
-        int y1 = node->board->light_queen_position / BOARD_SIZE;
-        int* points = get_points_around(y1, x1);
-        for (int i = 0; i < 6; i++) {
-            // If there is a tile around the queen of player 1, the value drops by 1
-            if (node->board->tiles[points[i]] != EMPTY)
-                queen_count -= 1;
-        }
-    }
-
-    if (node->board->dark_queen_position != -1) {
-        int x2 = node->board->dark_queen_position % BOARD_SIZE;
-        int y2 = node->board->dark_queen_position / BOARD_SIZE;
-        int* points = get_points_around(y2, x2);
-        for (int i = 0; i < 6; i++) {
-            // If there is a tile around the queen of player 2, the value increases by 1
-            if (node->board->tiles[points[i]] != EMPTY)
-                queen_count += 1;
-        }
-    }
-    value += queen_count * dtq_multipliers.queen;
+bool mm_evaluate_expqueen(struct node* node, struct rng* rng) {
+    return mm_evaluate_multipliers(node, rng, EVAL_QUEEN, &expqueen_multipliers, true);
+}
 
-    float dtql = distance_to_queen(node->board, node->board->light_queen_position, DARK);
-    float dtqd = distance_to_queen(node->board, node->board->dark_queen_position, LIGHT);
-    value += (dtql - dtqd) * dtq_multipliers.distance_to_queen;
+bool mm_evaluate_variable(struct node* node, struct rng* rng) {
+    return mm_evaluate_multipliers(node, rng, EVAL_VARIABLE, &evaluation_multipliers, false);
+}
 
-    data->mm_value = value;
-    return false;
-}
\ No newline at end of file
+bool mm_evaluate_distance(struct node* node, struct rng* rng) {
+    return mm_evaluate_multipliers(node, rng, EVAL_DISTANCE, &dtq_multipliers, false);
+}
@@ -8,9 +8,15 @@
 #define EVAL_QUEEN 1
 #define EVAL_VARIABLE 2
 #define EVAL_DISTANCE 3
+// Evaluation of the first play urgency in MCTS, only used to key the evaluation cache.
+#define EVAL_PRIORITIZATION 4
+
+#define EVAL_CACHE_SIZE (1 << 20)
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "../engine/node.h"
+#include "../engine/random.h"
 
 struct eval_multi {
     float queen;
@@ -20,11 +26,40 @@ struct eval_multi {
 };
 extern struct eval_multi evaluation_multipliers;
 
+/*
+ * Lossy cache of static evaluations keyed by zobrist hash, shared by all threads without locking.
+ * The check is the key xor the score, so an entry torn by concurrent writes is never returned.
+ */
+struct eval_cache_entry {
+    int64_t check;
+    union {
+        float score;
+        int32_t bits;
+    };
+};
+
+extern struct eval_cache_entry* eval_cache;
+extern unsigned long long eval_cache_probes, eval_cache_hits;
+
+void eval_cache_init();
+void eval_cache_clear();
+void eval_cache_prepare();
+bool eval_cache_probe(struct board* board, int function, float* score);
+void eval_cache_store(struct board* board, int function, float score);
+float eval_cache_hit_rate();
+
 float unused_tiles(struct node* node);
-bool mm_evaluate_expqueen(struct node* node);
-bool mm_evaluate_variable(struct node* node);
-bool mm_evaluate_distance(struct node* node);
+float distance_to_queen(struct board *board, int position, int color);
+void evaluation_features(struct node* node, bool weighted, struct eval_multi* features);
+float evaluation_dot(struct eval_multi* features, struct eval_multi* multipliers);
+float evaluation_score(struct node* node, int function);
+bool mm_evaluate_multipliers(struct node* node, struct rng* rng, int function, struct eval_multi* multipliers,
+                             bool weighted);
+bool mm_evaluate_expqueen(struct node* node, struct rng* rng);
+bool mm_evaluate_variable(struct node* node, struct rng* rng);
+bool mm_evaluate_distance(struct node* node, struct rng* rng);
 
-extern bool (*mm_evaluate)(struct node*);
+// The noise of the evaluation is drawn from the generator of the calling search.
+extern bool (*mm_evaluate)(struct node*, struct rng*);
 
 #endif //HIVE_EVALUATION_H
@@ -14,6 +14,7 @@
 #include <limits.h>
 #include "mm.h"
 #include "evaluation.h"
+#include "ordering.h"
 #include "../mcts/mcts.h"
 
 
@@ -39,10 +40,57 @@ void sort(struct node *node, bool max) {
     }
 }
 
-int leaf_nodes, n_created, n_evaluated, n_table_returns;
+int leaf_nodes, n_created, n_evaluated, n_table_returns, n_researches;
 int root_player;
+bool mm_pvs;
+// The positions of the game followed by the current path of the search.
+struct hash_history mm_history;
+
+bool mm(struct node *node, int player, float alpha, float beta, int depth, double end_time, struct rng *rng);
+
+/*
+ * Searches a child of a node at the given depth. With PVS, every child after the first is searched with a null window
+ *  at the bound of the player to move first, and only searched again with the full window if it improves that bound.
+ */
+bool mm_child(struct node *child, int player, float alpha, float beta, int depth, bool first, double end_time,
+              struct rng *rng) {
+    // The children of depth 1 nodes are evaluated directly, a null window does not make that cheaper.
+    if (first || !mm_pvs || depth <= 1) return mm(child, !player, alpha, beta, depth - 1, end_time, rng);
+
+    struct mm_data *data = child->data;
+    if (player == 0) {
+        if (!mm(child, !player, alpha, nextafterf(alpha, INFINITY), depth - 1, end_time, rng)) return false;
+        if (data->mm_value <= alpha || data->mm_value >= beta) return true;
+    } else {
+        if (!mm(child, !player, nextafterf(beta, -INFINITY), beta, depth - 1, end_time, rng)) return false;
+        if (data->mm_value >= beta || data->mm_value <= alpha) return true;
+    }
+
+#pragma omp atomic
+    n_researches++;
+    return mm(child, !player, alpha, beta, depth - 1, end_time, rng);
+}
+
+bool mm_node(struct node *node, int player, float alpha, float beta, int depth, double end_time, struct rng *rng);
+
+/*
+ * Searches a node, a position which repeats one earlier on the path is a draw as the players can keep repeating it.
+ */
+bool mm(struct node *node, int player, float alpha, float beta, int depth, double end_time, struct rng *rng) {
+    history_push(&mm_history, node->board);
+
+    bool done = true;
+    if (history_repetitions(&mm_history) > 0) {
+        ((struct mm_data *) node->data)->mm_value = 0;
+    } else {
+        done = mm_node(node, player, alpha, beta, depth, end_time, rng);
+    }
 
-bool mm(struct node *node, int player, float alpha, float beta, int depth, double end_time) {
+    history_pop(&mm_history);
+    return done;
+}
+
+bool mm_node(struct node *node, int player, float alpha, float beta, int depth, double end_time, struct rng *rng) {
     struct mm_data *data = node->data;
 
     // Lookup in table, and set values if value is found.
@@ -91,61 +139,79 @@ bool mm(struct node *node, int player, float alpha, float beta, int depth, doubl
         // If the game is finished or no more depth to evaluate.
 #pragma omp atomic
         leaf_nodes++;
-        mm_evaluate(node);
+        mm_evaluate(node, rng);
         return true;
     } else {
-        int err = generate_children(node, end_time, 0);
-        if (err) return false;
+        // Ant and spider moves are the most expensive to generate, and are only generated when the other moves did
+        //  not cause a cutoff. Unless the best or a killer move is one of them, then all moves are generated at once.
+        // A pass is left as the last stage, when none of the stages before had any moves.
+        int staged[] = {MOVE_NO_ANTS | MOVE_NO_SPIDERS, MOVE_ONLY_ANTS_SPIDERS, 0};
+        int all_at_once[] = {0};
+        int *stages = staged;
+        int n_stages = 3;
+
+        if (order_expects_ants_spiders(node->board)) {
+            stages = all_at_once;
+            n_stages = 1;
+        }
 
-        struct list *head, *hold;
-        if (node->board->n_children == 0 || list_empty(&node->children)) {
-            mm_evaluate(node);
-            best = data->mm_value;
-        } else if (player == 0) { // Player 0 maximizes
-            // Generate children for this child then compute values.
-            best = -INFINITY;
-            node_foreach(node, head) {
-                struct node *child = container_of(head, struct node, node);
-                struct mm_data *child_data = child->data;
+        struct move best_move;
+        bool has_best_move = false;
+        bool cutoff = false;
+        int i = 0;
+        best = player == 0 ? -INFINITY : INFINITY;
+        for (int stage = 0; stage < n_stages && !cutoff && next_sibling; stage++) {
+            if (stages[stage] == 0 && i > 0) break;
 
-                bool cont = mm(child, !player, alpha, beta, depth - 1, end_time);
-                if (!cont) {
-                    next_sibling = false;
-                    break;
-                }
+            int err = generate_children(node, end_time, stages[stage]);
+            if (err == ERR_NOMOVES && (stages[stage] & MOVE_PARTIAL)) continue;
+            if (err) return false;
 
-                float value = child_data->mm_value;
-                best = MAX(best, value);
-                alpha = MAX(best, alpha);
-                if (beta <= alpha) break;
-            }
-        } else { // Player 1 minimizes
-            best = INFINITY;
+            order_moves(node);
+
+            struct list *head, *hold;
             node_foreach(node, head) {
                 struct node *child = container_of(head, struct node, node);
                 struct mm_data *child_data = child->data;
 
-                bool cont = mm(child, !player, alpha, beta, depth - 1, end_time);
+                bool cont = mm_child(child, player, alpha, beta, depth, i == 0, end_time, rng);
                 if (!cont) {
                     next_sibling = false;
                     break;
                 }
 
+                // Player 0 maximizes, player 1 minimizes.
                 float value = child_data->mm_value;
+                if (player == 0 ? value > best : value < best) {
+                    best = value;
+                    best_move = child->move;
+                    has_best_move = true;
+                }
+                if (player == 0) {
+                    alpha = MAX(best, alpha);
+                } else {
+                    beta = MIN(best, beta);
+                }
+                if (beta <= alpha) {
+                    order_store_cutoff(node, child, depth, i == 0);
+                    cutoff = true;
+                    break;
+                }
+                i++;
+            }
 
-                best = MIN(best, value);
-                beta = MIN(best, beta);
-                if (beta <= alpha) break;
+            // Cleanup children.
+            node_foreach_safe(node, head, hold) {
+                struct node *child = container_of(head, struct node, node);
+                node->board->n_children--;
+                node_free(child);
             }
         }
 
-
-
-        // Cleanup children.
-        node_foreach_safe(node, head, hold) {
-            struct node *child = container_of(head, struct node, node);
-            node->board->n_children--;
-            node_free(child);
+        if (next_sibling && has_best_move) order_store_best(node, &best_move);
+        if (next_sibling && i == 0 && !cutoff) {
+            mm_evaluate(node, rng);
+            best = data->mm_value;
         }
     }
 
@@ -170,7 +236,7 @@ bool mm(struct node *node, int player, float alpha, float beta, int depth, doubl
 }
 
 
-float mm_par(struct node *node, int player, float alpha, float beta, int depth, double end_time) {
+float mm_par(struct node *node, int player, float alpha, float beta, int depth, double end_time, struct rng *rng) {
     struct mm_data *data = node->data;
     struct list *head;
 
@@ -229,7 +295,7 @@ float mm_par(struct node *node, int player, float alpha, float beta, int depth,
             struct mm_data *child_data = child->data;
 
             if (cont) {
-                cont = mm(child, !player, alpha, beta, depth - 1, end_time);
+                cont = mm(child, !player, alpha, beta, depth - 1, end_time, rng);
             }
             best = MAX(best, child_data->mm_value);
         }
@@ -240,7 +306,7 @@ float mm_par(struct node *node, int player, float alpha, float beta, int depth,
             struct mm_data *child_data = child->data;
 
             if (cont) {
-                cont = mm(child, !player, alpha, beta, depth - 1, end_time);
+                cont = mm(child, !player, alpha, beta, depth - 1, end_time, rng);
             }
 
             best = MIN(best, child_data->mm_value);
@@ -317,11 +383,19 @@ struct node *minimax(struct node *root, struct player_arguments *args) {
 
     int player = root->board->turn % 2;
     root_player = player;
+    history_start(&mm_history, args->history, root->board);
+    // Noise of the evaluation, owned by this search.
+    struct rng rng;
+    search_rng_seed(&rng, args, root->board);
 
     // Set the local add child function
     dedicated_add_child = mm_add_child;
     dedicated_init = mm_init;
 
+    ordering_reset();
+    eval_cache_prepare();
+    eval_cache_probes = eval_cache_hits = 0;
+
     mm_evaluate = mm_evaluate_variable;
     if (args->evaluation_function == EVAL_QUEEN) {
         // Set the evaluation function
@@ -343,23 +417,43 @@ struct node *minimax(struct node *root, struct player_arguments *args) {
     double end_time = (to_usec(cur_time) / 1e6) + args->time_to_move;
 
     int n_total_evaluated = 0;
+    // Scores of the last two iterations, the score of the same parity is the better guess.
+    float previous[2] = {0, 0};
+    int n_iterations = 0;
+    mm_pvs = args->pvs;
 
     while (true) {
-        leaf_nodes = n_evaluated = n_created = n_table_returns = 0;
+        leaf_nodes = n_evaluated = n_created = n_table_returns = n_researches = 0;
+        n_cutoffs = n_first_cutoffs = 0;
         clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cur_time);
-        if (to_usec(cur_time) / 1e6 > end_time) break;
+        if (to_usec(cur_time) / 1e6 > end_time || expansion_budget_spent()) break;
 
         if (args->verbose) {
             printf("Evaluating depth %d...", depth);
             fflush(stdout);
         }
 
-        float value = mm_par(root, player, -INFINITY, INFINITY, depth, end_time);
+        float value;
+        if (args->aspiration && n_iterations >= 2) {
+            // Search around the last score of the same parity first, the window is only opened if the score falls outside.
+            float guess = previous[depth % 2];
+            float alpha = guess - MM_ASPIRATION_WINDOW, beta = guess + MM_ASPIRATION_WINDOW;
+            value = mm_par(root, player, alpha, beta, depth, end_time, &rng);
+            if (value <= alpha || value >= beta) {
+                if (args->verbose) printf("outside aspiration window...");
+                value = mm_par(root, player, -INFINITY, INFINITY, depth, end_time, &rng);
+            }
+        } else {
+            value = mm_par(root, player, -INFINITY, INFINITY, depth, end_time, &rng);
+        }
+        previous[depth % 2] = value;
+        n_iterations++;
 
 
         if (args->verbose)
-            printf("(%d nodes, %d leaf, %d evaluated, %d table hits)\n", n_created, leaf_nodes, n_evaluated,
-                   n_table_returns);
+            printf("(%d nodes, %d leaf, %d evaluated, %d table hits, %.1f%% eval cache hits, "
+                   "%.1f%% first-move cutoffs, %d re-searches)\n", n_created, leaf_nodes, n_evaluated, n_table_returns,
+                   eval_cache_hit_rate(), n_cutoffs == 0 ? 0. : 100. * n_first_cutoffs / n_cutoffs, n_researches);
 
         // Sorting the list by MM-value increases likelihood of finding better moves earlier.
         // In turn, this improves alpha-beta pruning worse subtrees earlier.
@@ -11,6 +11,10 @@
 #include "utils.h"
 
 #define MM_INFINITY 10000000.0f
+// Half the width of the aspiration window around the score of the previous iteration.
+#ifndef MM_ASPIRATION_WINDOW
+#define MM_ASPIRATION_WINDOW 5.0f
+#endif
 
 struct mm_data {
     float mm_value;
@@ -0,0 +1,169 @@
+//
+// Move ordering for the minimax search.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ordering.h"
+
+// Best move per position from earlier searches, lossy and keyed by zobrist hash and side to move.
+struct order_entry *order_table = NULL;
+// Moves which caused a cutoff at the same ply in another branch.
+struct move order_killers[MAX_TURNS][ORDER_KILLERS];
+// Summed squared depth of the cutoffs per piece and destination.
+unsigned int order_history[N_UNIQUE_TILES * 2][BOARD_SIZE * BOARD_SIZE];
+
+unsigned int n_cutoffs, n_first_cutoffs;
+
+#define ORDER_SIDE_KEY 0x5851f42d4c957f2dll
+
+
+static inline int64_t order_key(struct board *board) {
+    return board->zobrist_hash ^ (board->turn % 2 ? ORDER_SIDE_KEY : 0);
+}
+
+static inline bool same_move(struct move *a, struct move *b) {
+    return a->tile == b->tile && a->location == b->location && a->previous_location == b->previous_location;
+}
+
+static inline int piece_index(unsigned char tile) {
+    return ((tile & COLOR_MASK) >> COLOR_SHIFT) * N_UNIQUE_TILES + (tile & TILE_MASK) - 1;
+}
+
+/*
+ * Forgets the best moves of earlier searches as well, if the table was allocated.
+ */
+void ordering_clear() {
+    if (order_table != NULL) memset(order_table, 0, ORDER_TABLE_SIZE * sizeof(struct order_entry));
+    memset(order_killers, 0, sizeof(order_killers));
+    memset(order_history, 0, sizeof(order_history));
+}
+
+/*
+ * Clears the killer moves and the history, the best moves are kept between searches.
+ */
+void ordering_reset() {
+    if (order_table == NULL) {
+        order_table = calloc(ORDER_TABLE_SIZE, sizeof(struct order_entry));
+        if (order_table == NULL) {
+            fprintf(stderr, "No memory left to allocate the move ordering table\n");
+            exit(1);
+        }
+    }
+    memset(order_killers, 0, sizeof(order_killers));
+    memset(order_history, 0, sizeof(order_history));
+}
+
+/*
+ * Finds the best move found in this position before, it is stored relative to the hive like the hash is, so it
+ *  applies wherever the hive lies on the board.
+ * Returns false if there is none.
+ */
+bool order_best_move(struct board *board, struct move *best) {
+    int64_t key = order_key(board);
+    struct order_entry *entry = &order_table[(uint64_t) key % ORDER_TABLE_SIZE];
+    if (entry->lock != key) return false;
+
+    *best = entry->move;
+    best->location = hive_absolute_location(board, best->location);
+    if (best->previous_location != -1)
+        best->previous_location = hive_absolute_location(board, best->previous_location);
+    return true;
+}
+
+static inline bool ant_or_spider_move(struct move *move) {
+    int type = move->tile & TILE_MASK;
+    return move->previous_location != -1 && (type == L_ANT || type == L_SPIDER);
+}
+
+/*
+ * Returns true if the best move or one of the killer moves of this position is an ant or spider move, these are
+ *  expected to be searched first.
+ */
+bool order_expects_ants_spiders(struct board *board) {
+    struct move best;
+    if (order_best_move(board, &best)) return ant_or_spider_move(&best);
+
+    struct move *killers = order_killers[board->turn];
+    for (int k = 0; k < ORDER_KILLERS; k++) {
+        if (killers[k].tile != 0 && ant_or_spider_move(&killers[k])) return true;
+    }
+    return false;
+}
+
+/*
+ * Sorts the children of the node, the best move found in this position before goes first, then the killer moves
+ *  of this ply, then moves which add a tile around the queen of the opponent, and then the rest by their history score.
+ * Equal scores keep their generation order.
+ */
+void order_moves(struct node *node) {
+    struct board *board = node->board;
+    struct move best;
+    bool has_best = order_best_move(board, &best);
+    struct move *killers = order_killers[board->turn];
+    int opponent = (board->turn + 1) % 2;
+
+    int n = 0;
+    struct node *children[board->n_children];
+    long long scores[board->n_children];
+
+    struct list *head;
+    node_foreach(node, head) {
+        struct node *child = container_of(head, struct node, node);
+        struct move *move = &child->move;
+
+        long long score = 0;
+        if (move->tile != 0) {
+            score = order_history[piece_index(move->tile)][move->location];
+            if (has_best && same_move(move, &best)) score += ORDER_BEST_MOVE;
+            for (int k = 0; k < ORDER_KILLERS; k++) {
+                if (same_move(move, &killers[k])) score += ORDER_KILLER >> k;
+            }
+            if (child->board->eval.queen_neighbours[opponent] > board->eval.queen_neighbours[opponent])
+                score += ORDER_QUEEN_PRESSURE;
+        }
+
+        // Insertion sort, children are few.
+        int i = n++;
+        for (; i > 0 && scores[i - 1] < score; i--) {
+            scores[i] = scores[i - 1];
+            children[i] = children[i - 1];
+        }
+        scores[i] = score;
+        children[i] = child;
+    }
+
+    for (int i = 0; i < n; i++) {
+        list_remove(&children[i]->node);
+        list_add(&node->children, &children[i]->node);
+    }
+}
+
+void order_store_best(struct node *node, struct move *best) {
+    int64_t key = order_key(node->board);
+    struct order_entry *entry = &order_table[(uint64_t) key % ORDER_TABLE_SIZE];
+    entry->lock = key;
+    entry->move = *best;
+    entry->move.location = hive_relative_location(node->board, best->location);
+    if (best->previous_location != -1)
+        entry->move.previous_location = hive_relative_location(node->board, best->previous_location);
+}
+
+/*
+ * Remembers the move which caused a cutoff as killer of this ply, and rewards its piece and destination.
+ */
+void order_store_cutoff(struct node *node, struct node *child, int depth, bool first) {
+    n_cutoffs++;
+    if (first) n_first_cutoffs++;
+
+    struct move *move = &child->move;
+    if (move->tile == 0) return;
+
+    struct move *killers = order_killers[node->board->turn];
+    if (!same_move(move, &killers[0])) {
+        killers[1] = killers[0];
+        killers[0] = *move;
+    }
+    order_history[piece_index(move->tile)][move->location] += depth * depth;
+}
@@ -0,0 +1,36 @@
+//
+// Move ordering for the minimax search.
+//
+
+#ifndef HIVE_ORDERING_H
+#define HIVE_ORDERING_H
+
+#include <stdint.h>
+#include "../engine/node.h"
+#include "../engine/board.h"
+
+#define ORDER_TABLE_SIZE (1 << 18)
+#define ORDER_KILLERS 2
+
+// Scores which place the best move, the killer moves and moves next to the queen of the opponent before every move
+//  sorted by history.
+#define ORDER_BEST_MOVE (1ll << 40)
+#define ORDER_KILLER (1ll << 36)
+#define ORDER_QUEEN_PRESSURE (1ll << 32)
+
+struct order_entry {
+    int64_t lock;
+    struct move move;
+};
+
+extern unsigned int n_cutoffs, n_first_cutoffs;
+
+void ordering_reset();
+void ordering_clear();
+bool order_best_move(struct board *board, struct move *best);
+bool order_expects_ants_spiders(struct board *board);
+void order_moves(struct node *node);
+void order_store_best(struct node *node, struct move *best);
+void order_store_cutoff(struct node *node, struct node *child, int depth, bool first);
+
+#endif //HIVE_ORDERING_H
@@ -19,9 +19,11 @@ int main(int argc, char** argv) {
     printf("Running perft with depth %d on %d threads.\n", max_depth, omp_get_max_threads());
 
     struct node* tree = game_init();
-    srand(0);
+    // Fixed seed, so the random moves below are the same in every run.
+    struct rng rng;
+    rng_seed(&rng, 0);
 
-//    tree = random_moves(tree, 10);
+//    tree = random_moves(tree, 10, &rng);
 
     int last = 0;
     struct timespec start, end;
@@ -0,0 +1,425 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "dfpn.h"
+#include "pns.h"
+
+// Children are searched until their numbers exceed the second best by 1 / DFPN_EPSILON_DIVISOR.
+#define DFPN_EPSILON_DIVISOR 4
+
+// Distinguishes the same tiles with a different player to move, or a different player to prove a win for.
+#define DFPN_SIDE_KEY 0x5bd1e9955bd1e995ll
+#define DFPN_ATTACKER_KEY 0x27d4eb2f165667c5ll
+
+struct dfpn_entry *dfpn_table = NULL;
+unsigned long long dfpn_n_expanded = 0;
+
+struct dfpn_search {
+    int original_player_bit;
+    double end_time;
+    int max_depth;
+    bool timeout;
+
+    // Parallel searches share the table, and stop together as soon as one thread solves the root.
+    bool parallel;
+    bool *stop;
+    int thread;
+    int n_threads;
+
+    // Hashes of the positions on the current path, to detect repetitions.
+    int64_t path[MAX_TURNS + 1];
+    int path_length;
+};
+
+void dfpn_init() {
+    dfpn_table = malloc(DFPN_TABLE_SIZE * sizeof(struct dfpn_entry));
+    if (dfpn_table == NULL) {
+        fprintf(stderr, "No memory left to allocate the df-pn table\n");
+        exit(1);
+    }
+    dfpn_clear();
+}
+
+void dfpn_clear() {
+    // Proof and disproof number 0 never occur together, this marks an empty entry.
+    memset(dfpn_table, 0, DFPN_TABLE_SIZE * sizeof(struct dfpn_entry));
+}
+
+static double dfpn_cpu_time() {
+    struct timespec cur_time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cur_time);
+    return to_usec(cur_time) / 1e6;
+}
+
+static inline int64_t dfpn_key(struct board *board, int original_player_bit) {
+    return board->zobrist_hash ^ (board->turn % 2 ? DFPN_SIDE_KEY : 0) ^ (original_player_bit ? DFPN_ATTACKER_KEY : 0);
+}
+
+static inline struct dfpn_entry *dfpn_slot(int64_t key) {
+    return &dfpn_table[(uint64_t) key % DFPN_TABLE_SIZE];
+}
+
+static inline bool pn_solved(struct pn_data *data) {
+    return data->to_prove == 0 || data->to_disprove == 0;
+}
+
+/*
+ * Exactly one of the numbers is 0 for a solved entry, both are 0 for an empty one.
+ */
+static inline bool dfpn_entry_solved(struct dfpn_entry *entry) {
+    return (entry->to_prove == 0) != (entry->to_disprove == 0);
+}
+
+/*
+ * Adds two proof numbers, finite sums stay below PN_INF so they are not mistaken for a (dis)proof.
+ */
+static inline unsigned int pn_add(unsigned int a, unsigned int b) {
+    if (a >= PN_INF || b >= PN_INF) return PN_INF;
+    return MIN(a + b, PN_INF - 1);
+}
+
+/*
+ * Sets the proof numbers of a node from the table, or initializes them as a leaf if it was not stored.
+ * Entries searched with another amount of remaining plies are only used if they are still valid, which is
+ *  a proof with less remaining plies, or a disproof with more.
+ */
+static bool dfpn_read(struct node *node, int original_player_bit, int remaining) {
+    struct pn_data *data = node->data;
+    int64_t key = dfpn_key(node->board, original_player_bit);
+    struct dfpn_entry *entry = dfpn_slot(key);
+    bool found = false;
+
+#pragma omp critical (dfpn)
+    {
+        if (entry->lock == key && (entry->to_prove != 0 || entry->to_disprove != 0)) {
+            data->n_searching = entry->n_searching;
+            if (entry->remaining == remaining
+                || (entry->to_prove == 0 && entry->remaining <= remaining)
+                || (entry->to_disprove == 0 && entry->remaining >= remaining)) {
+                data->to_prove = entry->to_prove;
+                data->to_disprove = entry->to_disprove;
+                found = true;
+            }
+        } else {
+            data->n_searching = 0;
+        }
+    }
+    return found;
+}
+
+static void dfpn_lookup(struct node *node, int original_player_bit, int remaining) {
+    ((struct pn_data *) node->data)->path_dependent = false;
+    if (!dfpn_read(node, original_player_bit, remaining)) set_proof_numbers(node, original_player_bit);
+}
+
+static void dfpn_store(struct node *node, int original_player_bit, int remaining) {
+    struct pn_data *data = node->data;
+    // Such a disproof does not hold when the position is reached through another path, or at another turn.
+    if (data->path_dependent) return;
+
+    int64_t key = dfpn_key(node->board, original_player_bit);
+    struct dfpn_entry *entry = dfpn_slot(key);
+
+#pragma omp critical (dfpn)
+    {
+        // Solved positions are only replaced by other solved positions.
+        if (entry->lock == key || !dfpn_entry_solved(entry) || pn_solved(data)) {
+            if (entry->lock != key) entry->n_searching = 0;
+
+            entry->lock = key;
+            entry->to_prove = data->to_prove;
+            entry->to_disprove = data->to_disprove;
+            entry->remaining = (unsigned char) remaining;
+        }
+    }
+}
+
+/*
+ * Registers a thread entering (1) or leaving (-1) the search of a node in the table.
+ * Entering claims the slot if it holds another unsolved position, an entry of the node itself is left as it is,
+ *  since another thread may have stored better numbers since this node was read.
+ */
+static void dfpn_mark(struct node *node, int original_player_bit, int remaining, int delta) {
+    struct pn_data *data = node->data;
+    int64_t key = dfpn_key(node->board, original_player_bit);
+    struct dfpn_entry *entry = dfpn_slot(key);
+
+#pragma omp critical (dfpn)
+    {
+        if (delta > 0 && entry->lock != key && !dfpn_entry_solved(entry) && !pn_solved(data)) {
+            entry->lock = key;
+            entry->to_prove = data->to_prove;
+            entry->to_disprove = data->to_disprove;
+            entry->remaining = (unsigned char) remaining;
+            entry->n_searching = 0;
+        }
+        if (entry->lock == key && (delta > 0 || entry->n_searching > 0))
+            entry->n_searching += delta;
+    }
+}
+
+/*
+ * Updates the children with the proof numbers other threads found, solved children are kept as they are
+ *  because repetitions and the turn limit are not stored.
+ */
+static void dfpn_refresh(struct node *node, int original_player_bit, int remaining) {
+    struct list *head;
+    node_foreach(node, head) {
+        struct node *child = container_of(head, struct node, node);
+        if (pn_solved(child->data)) continue;
+
+        dfpn_read(child, original_player_bit, remaining);
+    }
+}
+
+/*
+ * Combines the proof numbers of the children, and returns the most proving child.
+ * The proof (OR) or disproof (AND) number of the second best child is stored in second.
+ * Ties are broken from a different child for every thread, otherwise they would all search in the same order.
+ */
+static struct node *dfpn_select(struct node *node, int thread, int n_threads, unsigned int *second) {
+    struct pn_data *data = node->data;
+    struct node *best = NULL;
+    unsigned int best_value = PN_INF;
+    *second = PN_INF;
+
+    int n = node->board->n_children;
+    int offset = thread * n / n_threads;
+    int index = 0, best_rank = 0;
+
+    bool is_or = data->node_type == PN_TYPE_OR;
+    data->to_prove = is_or ? PN_INF : 0;
+    data->to_disprove = is_or ? 0 : PN_INF;
+
+    // A disproof of an OR node depends on the path if any child's does, of an AND node if every disproven child's does.
+    bool any_dependent = false, all_dependent = true;
+
+    struct list *head;
+    node_foreach(node, head) {
+        struct node *child = container_of(head, struct node, node);
+        struct pn_data *child_data = child->data;
+
+        unsigned int value = is_or ? child_data->to_prove : child_data->to_disprove;
+        // Nodes which are searched by other threads look less attractive.
+        if (value != 0 && child_data->n_searching > 0)
+            value = pn_add(value, child_data->n_searching * DFPN_VIRTUAL_INFLATION);
+
+        if (child_data->to_disprove == 0) {
+            any_dependent |= child_data->path_dependent;
+            all_dependent &= child_data->path_dependent;
+        }
+
+        if (is_or) {
+            data->to_prove = MIN(data->to_prove, child_data->to_prove);
+            data->to_disprove = pn_add(data->to_disprove, child_data->to_disprove);
+        } else {
+            data->to_disprove = MIN(data->to_disprove, child_data->to_disprove);
+            data->to_prove = pn_add(data->to_prove, child_data->to_prove);
+        }
+
+        int rank = (index++ - offset + n) % n;
+        if (best == NULL || value < best_value || (value == best_value && rank < best_rank)) {
+            *second = best_value;
+            best_value = value;
+            best_rank = rank;
+            best = child;
+        } else if (value < *second) {
+            *second = value;
+        }
+    }
+    data->path_dependent = data->to_disprove == 0 && (is_or ? any_dependent : all_dependent);
+    return best;
+}
+
+/*
+ * Multiple iterative deepening of a node, searches until one of the thresholds is reached.
+ * Only the current path is kept in memory, everything else is remembered through the table.
+ */
+static void dfpn_mid(struct dfpn_search *search, struct node *node, struct node *root,
+                     unsigned int th_prove, unsigned int th_disprove) {
+    struct pn_data *data = node->data;
+    if (pn_solved(data) || data->to_prove >= th_prove || data->to_disprove >= th_disprove) return;
+
+    if (search->parallel) {
+        bool stop;
+#pragma omp atomic read
+        stop = *search->stop;
+        if (stop) {
+            search->timeout = true;
+            return;
+        }
+    }
+
+    // Unlimited searches share their entries between all depths.
+    int remaining = search->max_depth == DFPN_UNLIMITED ? DFPN_UNLIMITED : search->max_depth - search->path_length;
+    if (remaining == 0) {
+        // Positions past the maximum depth are not proven.
+        data->to_prove = PN_INF;
+        data->to_disprove = 0;
+        return;
+    }
+
+    // A repeated position does not prove anything, this is not stored because it depends on the path.
+    int64_t key = dfpn_key(node->board, search->original_player_bit);
+    for (int i = 0; i < search->path_length; i++) {
+        if (search->path[i] == key) {
+            data->to_prove = PN_INF;
+            data->to_disprove = 0;
+            data->path_dependent = true;
+            return;
+        }
+    }
+
+    int error = generate_children(node, search->end_time, 0);
+    if (error == ERR_NOTIME || error == ERR_NOMEM) {
+        search->timeout = true;
+        return;
+    }
+    if (error == ERR_NOMOVES) {
+        // Running out of turns is a draw, which cannot be proven either. The key has no turn, so it is not stored.
+        data->to_prove = PN_INF;
+        data->to_disprove = 0;
+        data->path_dependent = true;
+        return;
+    }
+    data->expanded = true;
+
+#pragma omp atomic
+    dfpn_n_expanded++;
+
+    int child_remaining = remaining == DFPN_UNLIMITED ? DFPN_UNLIMITED : remaining - 1;
+    struct list *head;
+    node_foreach(node, head) {
+        dfpn_lookup(container_of(head, struct node, node), search->original_player_bit, child_remaining);
+    }
+
+    search->path[search->path_length++] = key;
+    while (true) {
+        if (search->parallel) dfpn_refresh(node, search->original_player_bit, child_remaining);
+
+        unsigned int second;
+        struct node *best = dfpn_select(node, search->thread, search->n_threads, &second);
+        dfpn_store(node, search->original_player_bit, remaining);
+
+        if (search->timeout || data->to_prove >= th_prove || data->to_disprove >= th_disprove) break;
+
+        // The child may exceed the second best child by a fraction (1 + epsilon trick), so the search
+        //  does not alternate between two similar children.
+        unsigned int second_threshold = pn_add(second, second / DFPN_EPSILON_DIVISOR + 1);
+
+        struct pn_data *best_data = best->data;
+        unsigned int child_th_prove, child_th_disprove;
+        if (data->node_type == PN_TYPE_OR) {
+            child_th_prove = MIN(th_prove, second_threshold);
+            child_th_disprove = th_disprove >= PN_INF ? PN_INF
+                                                      : th_disprove - data->to_disprove + best_data->to_disprove;
+        } else {
+            child_th_disprove = MIN(th_disprove, second_threshold);
+            child_th_prove = th_prove >= PN_INF ? PN_INF
+                                                : th_prove - data->to_prove + best_data->to_prove;
+        }
+        if (search->parallel) dfpn_mark(best, search->original_player_bit, child_remaining, 1);
+        dfpn_mid(search, best, root, child_th_prove, child_th_disprove);
+        if (search->parallel) dfpn_mark(best, search->original_player_bit, child_remaining, -1);
+    }
+    search->path_length--;
+
+    // The root keeps its children, so the caller can select the proving move.
+    if (node != root) {
+        node_free_children(node);
+        data->expanded = false;
+    }
+}
+
+/*
+ * Returns a new root node for a copy of the board, with its own search tree.
+ */
+static struct node *dfpn_new_root(struct board *source, int node_type) {
+    struct node *root = malloc(sizeof(struct node));
+    struct board *board = malloc(sizeof(struct board));
+    if (root == NULL || board == NULL) {
+        fprintf(stderr, "No memory left to allocate a df-pn root\n");
+        exit(1);
+    }
+    memcpy(board, source, sizeof(struct board));
+    board->n_children = 0;
+
+    pn_init(root, node_type);
+    root->board = board;
+    return root;
+}
+
+/*
+ * Depth-first proof-number search, proving whether the player original_player_bit can force a win from root.
+ * The root has to be initialized with pn_init, its proof numbers and those of its children are set afterwards.
+ * If max_depth is larger than 0, only wins within that many plies are proven (a puzzle with mate in N has 2N - 1).
+ * With more than 1 thread, every thread searches its own tree from the root while sharing the table. Threads
+ *  searching a node inflate its proof numbers for the others, so they spread over different most-proving nodes.
+ * Returns DFPN_PROVEN, DFPN_DISPROVEN, or DFPN_UNKNOWN if the time ran out first.
+ */
+int DFPN(struct node *root, int original_player_bit, double end_time, int max_depth, int n_threads) {
+    if (dfpn_table == NULL) dfpn_init();
+
+    // The time limit is in cpu time of the calling thread, every thread gets the same budget.
+    double budget = end_time - dfpn_cpu_time();
+    bool stop = false;
+#pragma omp parallel num_threads(MAX(n_threads, 1))
+    {
+        // The search tree uses proof number data for its nodes, only for the searching threads.
+        struct node *(*add_child)(struct node *, struct board *) = thread_add_child;
+        thread_add_child = pn_add_child;
+
+        struct dfpn_search search = {0};
+        search.original_player_bit = original_player_bit;
+        search.end_time = dfpn_cpu_time() + budget;
+        search.max_depth = max_depth > 0 ? MIN(max_depth, DFPN_UNLIMITED - 1) : DFPN_UNLIMITED;
+        search.parallel = n_threads > 1;
+        search.stop = &stop;
+        search.thread = omp_get_thread_num();
+        search.n_threads = MAX(n_threads, 1);
+
+        struct node *thread_root = root;
+        if (search.thread != 0) {
+            thread_root = dfpn_new_root(root->board, ((struct pn_data *) root->data)->node_type);
+            thread_root->move = root->move;
+        }
+        set_proof_numbers(thread_root, original_player_bit);
+        dfpn_mid(&search, thread_root, thread_root, PN_INF, PN_INF);
+
+        if (pn_solved(thread_root->data)) {
+#pragma omp atomic write
+            stop = true;
+        }
+        if (thread_root != root) node_free(thread_root);
+        thread_add_child = add_child;
+    }
+
+    // Another thread could have solved the root, so take the shared results for the children.
+    struct pn_data *data = root->data;
+    if (n_threads > 1 && data->expanded) {
+        unsigned int second;
+        dfpn_refresh(root, original_player_bit, max_depth > 0 ? MIN(max_depth, DFPN_UNLIMITED - 1) - 1 : DFPN_UNLIMITED);
+        dfpn_select(root, 0, 1, &second);
+    }
+
+    if (data->to_prove == 0) return DFPN_PROVEN;
+    if (data->to_disprove == 0) return DFPN_DISPROVEN;
+    return DFPN_UNKNOWN;
+}
+
+/*
+ * Tries to prove a win for the player to move within max_depth plies, on a copy of the board.
+ * Returns the finished_board value of that win (1 or 2), or 0 if it was not found within the depth and time.
+ */
+int dfpn_solve(struct board *board, double end_time, int max_depth) {
+    int player = board->turn % 2;
+    struct node *root = dfpn_new_root(board, PN_TYPE_OR);
+
+    int result = DFPN(root, player << COLOR_SHIFT, end_time, max_depth, 1);
+    node_free(root);
+
+    if (result != DFPN_PROVEN) return 0;
+    return player == 0 ? 1 : 2;
+}
@@ -0,0 +1,37 @@
+
+#ifndef HIVE_DFPN_H
+#define HIVE_DFPN_H
+
+#include <stdint.h>
+#include "pn_tree.h"
+#include "../engine/moves.h"
+
+#define DFPN_TABLE_SIZE (1 << 20)
+// Depth used for searches without a maximum depth, the turn limit ends these instead.
+#define DFPN_UNLIMITED 255
+// Virtual proof number added per thread searching a node, so other threads pick another node.
+#define DFPN_VIRTUAL_INFLATION 4
+
+#define DFPN_UNKNOWN (-1)
+#define DFPN_DISPROVEN 0
+#define DFPN_PROVEN 1
+
+struct dfpn_entry {
+    int64_t lock;
+    unsigned int to_prove;
+    unsigned int to_disprove;
+    // Amount of plies the entry was searched with.
+    unsigned char remaining;
+    // Amount of threads currently searching this position.
+    unsigned short n_searching;
+};
+
+extern struct dfpn_entry *dfpn_table;
+extern unsigned long long dfpn_n_expanded;
+
+void dfpn_init();
+void dfpn_clear();
+int DFPN(struct node *root, int original_player_bit, double end_time, int max_depth, int n_threads);
+int dfpn_solve(struct board *board, double end_time, int max_depth);
+
+#endif //HIVE_DFPN_H
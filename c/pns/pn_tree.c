@@ -13,6 +13,8 @@ void pn_init(struct node* root, int type) {
     data->to_disprove = PN_INF;
     data->to_prove = PN_INF;
     data->expanded = false;
+    data->n_searching = 0;
+    data->path_dependent = false;
 
     node_init(root, (void*)data);
 }
@@ -11,13 +11,17 @@
 
 #define PN_TYPE_AND 0
 #define PN_TYPE_OR 1
-#define PN_INF (1 << 31)
+#define PN_INF (1u << 31)
 
 struct pn_data {
     unsigned int to_prove;
     unsigned int to_disprove;
     int node_type;
     bool expanded;
+    // Amount of other threads searching this node, only used by the parallel df-pn.
+    unsigned int n_searching;
+    // The disproof depends on the path to this node (a repetition or the turn limit), only used by df-pn.
+    bool path_dependent;
 };
 
 void pn_init(struct node* root, int type);
@@ -8,7 +8,7 @@
 #include "pns.h"
 
 
-void do_pn_random_move(struct node **proot) {
+void do_pn_random_move(struct node **proot, struct rng *rng) {
     /*
      * Selects a random node from the PN tree, and replaces the root with the child.
      */
@@ -28,7 +28,7 @@ void do_pn_random_move(struct node **proot) {
         board->turn++;
         return;
     }
-    int selected = rand() % board->n_children;
+    int selected = (int) rng_below(rng, board->n_children);
 
 
 
@@ -3,275 +3,160 @@
 //
 
 #include <board.h>
+#include <moves.h>
+#include <tt.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "puzzles.h"
 
 #define make_tile(tile, number) ((tile) | ((number) << NUMBER_SHIFT))
-
-void set_board_information(struct board* board) {
-    // Set correct min x and y
-    board->min_x = board->min_y = 0;
-    board->max_x = board->max_y = BOARD_SIZE - 1;
-    get_min_x_y(board, &board->min_x, &board->min_y);
-    get_max_x_y(board, &board->max_x, &board->max_y);
-
-    for (int i = board->min_x; i < board->max_x + 1; i++) {
-        for (int j = board->min_y; j < board->max_y + 1; j++) {
-            int idx = j * BOARD_SIZE + i;
-            if (board->tiles[idx] == EMPTY)
-                continue;
-            int color = board->tiles[idx] & COLOR_MASK;
-            int type = board->tiles[idx] & TILE_MASK;
-            int player = color >> COLOR_SHIFT;
-
-            if (type == L_GRASSHOPPER)
-                board->players[player].grasshoppers_left--;
-            if (type == L_ANT)
-                board->players[player].ants_left--;
-            if (type == L_BEETLE)
-                board->players[player].beetles_left--;
-            if (type == L_QUEEN) {
-                board->players[player].queens_left--;
-                if (player == 0)
-                    board->light_queen_position = idx;
-                else
-                    board->dark_queen_position = idx;
-            }
-            if (type == L_SPIDER)
-                board->players[player].spiders_left--;
-        }
+#define PUZZLE_LINE_LENGTH 256
+
+/*
+ * Converts a tile as written by string_tile (color, type and number, like wB1) to its tile value.
+ * Returns EMPTY if the tile is not valid.
+ */
+unsigned char parse_tile(const char* str) {
+    if (strlen(str) != 3) return EMPTY;
+
+    unsigned char tile;
+    if (str[0] == 'w') {
+        tile = LIGHT;
+    } else if (str[0] == 'b') {
+        tile = DARK;
+    } else {
+        return EMPTY;
     }
 
-    // Count for stacked tiles too
-    for (int i = 0; i < board->n_stacked; i++) {
-        struct tile_stack ts = board->stack[i];
-        int color = ts.type & COLOR_MASK;
-        int type = ts.type & TILE_MASK;
-        int player = color >> COLOR_SHIFT;
-
-        printf("%d %d is in stack\n", color, type);
-
-        if (type == L_GRASSHOPPER)
-            board->players[player].grasshoppers_left--;
-        if (type == L_ANT)
-            board->players[player].ants_left--;
-        if (type == L_BEETLE)
-            board->players[player].beetles_left--;
-        if (type == L_QUEEN) {
-            board->players[player].queens_left--;
-            if (player == 0)
-                board->light_queen_position = ts.location;
-            else
-                board->dark_queen_position = ts.location;
-        }
-        if (type == L_SPIDER)
-            board->players[player].spiders_left--;
+    if (str[1] == 'A') {
+        tile |= L_ANT;
+    } else if (str[1] == 'B') {
+        tile |= L_BEETLE;
+    } else if (str[1] == 'Q') {
+        tile |= L_QUEEN;
+    } else if (str[1] == 'G') {
+        tile |= L_GRASSHOPPER;
+    } else if (str[1] == 'S') {
+        tile |= L_SPIDER;
+    } else {
+        return EMPTY;
     }
-}
-
-void puzzle_4(struct node* tree) {
-    int white_to_move = 1;
-
-    struct board* board = tree->board;
-
-    board->turn = white_to_move + 9;
 
-    board->tiles[0 * BOARD_SIZE + 3] = make_tile(L_GRASSHOPPER, 1);
-    board->tiles[0 * BOARD_SIZE + 4] = make_tile(L_ANT, 2);
-
-    board->tiles[1 * BOARD_SIZE + 0] = make_tile(D_ANT, 2);
-    board->tiles[1 * BOARD_SIZE + 1] = make_tile(D_GRASSHOPPER, 2);
-    board->tiles[1 * BOARD_SIZE + 3] = make_tile(L_SPIDER, 2);
-    board->tiles[1 * BOARD_SIZE + 4] = make_tile(D_QUEEN, 1);
-    board->tiles[1 * BOARD_SIZE + 5] = make_tile(L_ANT, 1);
-
-    board->tiles[2 * BOARD_SIZE + 2] = make_tile(L_ANT, 3);
-    board->tiles[2 * BOARD_SIZE + 3] = make_tile(D_SPIDER, 1);
-    board->tiles[2 * BOARD_SIZE + 5] = make_tile(L_SPIDER, 1);
-
-    board->tiles[3 * BOARD_SIZE + 2] = make_tile(D_GRASSHOPPER, 1);
-    board->tiles[3 * BOARD_SIZE + 3] = make_tile(D_BEETLE, 2);
-    board->tiles[3 * BOARD_SIZE + 5] = make_tile(D_BEETLE, 1);
-    board->stack[0].location = 3 * BOARD_SIZE + 3;
-    board->stack[0].z = 0;
-    board->stack[0].type = make_tile(L_QUEEN, 1);
-    board->stack[1].location = 3 * BOARD_SIZE + 3;
-    board->stack[1].z = 1;
-    board->stack[1].type = make_tile(L_BEETLE, 1);
-
-    board->tiles[4 * BOARD_SIZE + 3] = make_tile(D_ANT, 1);
-
-    board->n_stacked = 2;
+    if (str[2] < '1' || str[2] > '3') return EMPTY;
+    return make_tile(tile, str[2] - '0');
 }
 
-void puzzle_5(struct node* tree) {
-    int white_to_move = 0;
-
-    struct board* board = tree->board;
-
-    board->turn = white_to_move + 9;
-
-    board->tiles[0 * BOARD_SIZE + 4] = make_tile(L_BEETLE, 1);
-    board->stack[0].location = 0 * BOARD_SIZE + 4;
-    board->stack[0].z = 0;
-    board->stack[0].type = make_tile(D_GRASSHOPPER, 2);
-    board->tiles[0 * BOARD_SIZE + 5] = make_tile(D_SPIDER, 2);
-
-    board->tiles[1 * BOARD_SIZE + 0] = make_tile(D_SPIDER, 1);
-    board->tiles[1 * BOARD_SIZE + 1] = make_tile(D_ANT, 1);
-    board->tiles[1 * BOARD_SIZE + 2] = make_tile(L_ANT, 1);
-    board->tiles[1 * BOARD_SIZE + 4] = make_tile(D_QUEEN, 1);
-
-    board->tiles[2 * BOARD_SIZE + 1] = make_tile(D_BEETLE, 2);
-    board->stack[1].location = 2 * BOARD_SIZE + 1;
-    board->stack[1].z = 0;
-    board->stack[1].type = make_tile(L_QUEEN, 1);
-    board->tiles[2 * BOARD_SIZE + 3] = make_tile(D_GRASSHOPPER, 1);
-    board->tiles[2 * BOARD_SIZE + 4] = make_tile(L_GRASSHOPPER, 1);
-
-    board->tiles[3 * BOARD_SIZE + 1] = make_tile(D_ANT, 2);
-    board->tiles[4 * BOARD_SIZE + 2] = make_tile(D_BEETLE, 1);
-    board->tiles[5 * BOARD_SIZE + 2] = make_tile(L_ANT, 3);
-    board->tiles[5 * BOARD_SIZE + 3] = make_tile(L_ANT, 2);
-
-    board->tiles[6 * BOARD_SIZE + 3] = make_tile(D_ANT, 3);
+/*
+ * Places a stack of tiles (bottom to top, separated by spaces) on the board.
+ * Returns false if a tile is not valid or the stack does not fit.
+ */
+bool place_tiles(struct board* board, int location, char* tiles) {
+    unsigned char below = EMPTY;
+    int z = 0;
+    for (char* token = strtok(tiles, " \t\n"); token != NULL; token = strtok(NULL, " \t\n")) {
+        unsigned char tile = parse_tile(token);
+        if (tile == EMPTY) return false;
+
+        if (below != EMPTY) {
+            if (board->n_stacked == TILE_STACK_SIZE) return false;
+
+            struct tile_stack* ts = &board->stack[(int) board->n_stacked++];
+            ts->location = location;
+            ts->type = below;
+            ts->z = z++;
+        }
+        below = tile;
+    }
+    if (below == EMPTY) return false;
 
-    board->n_stacked = 2;
+    board->tiles[location] = below;
+    return true;
 }
 
+/*
+ * Reads the next puzzle from the file, see puzzles.txt for the format.
+ * The board of the puzzle is allocated here, and is ready to generate children for.
+ * Returns 1 if a puzzle was read, 0 if there are no puzzles left and -1 if the file is not valid.
+ */
+int read_puzzle(FILE* file, struct puzzle* puzzle) {
+    char line[PUZZLE_LINE_LENGTH];
+    struct board* board = NULL;
+
+    while (fgets(line, PUZZLE_LINE_LENGTH, file) != NULL) {
+        // Skip comments and empty lines.
+        line[strcspn(line, "#\n")] = '\0';
+
+        char word[PUZZLE_LINE_LENGTH];
+        int offset;
+        if (sscanf(line, "%255s%n", word, &offset) != 1) continue;
+
+        if (board == NULL) {
+            char to_move[PUZZLE_LINE_LENGTH];
+            if (strcmp(word, "puzzle") != 0
+                || sscanf(line + offset, "%31s %255s %d", puzzle->name, to_move, &puzzle->plies) != 3
+                || (strcmp(to_move, "light") != 0 && strcmp(to_move, "dark") != 0)) {
+                fprintf(stderr, "Expected 'puzzle <name> <light|dark> <plies>', got: %s\n", line);
+                return -1;
+            }
 
-void puzzle_10(struct node* tree) {
-    int white_to_move = 0;
-
-    struct board* board = tree->board;
-
-    board->turn = white_to_move + 9;
-
-    board->tiles[0 * BOARD_SIZE + 1] = make_tile(L_SPIDER, 1);
-    board->tiles[0 * BOARD_SIZE + 3] = make_tile(L_GRASSHOPPER, 3);
-    board->tiles[0 * BOARD_SIZE + 4] = make_tile(D_ANT, 1);
-    board->tiles[0 * BOARD_SIZE + 5] = make_tile(L_GRASSHOPPER, 2);
-
-    board->tiles[1 * BOARD_SIZE + 0] = make_tile(L_SPIDER, 2);
-    board->tiles[1 * BOARD_SIZE + 2] = make_tile(D_SPIDER, 1);
-    board->tiles[1 * BOARD_SIZE + 3] = make_tile(D_ANT, 2);
-    board->tiles[1 * BOARD_SIZE + 6] = make_tile(L_GRASSHOPPER, 1);
-
-    board->tiles[2 * BOARD_SIZE + 1] = make_tile(D_GRASSHOPPER, 2);
-    board->tiles[2 * BOARD_SIZE + 2] = make_tile(L_ANT, 3);
-    board->tiles[2 * BOARD_SIZE + 3] = make_tile(L_QUEEN, 1);
-    board->tiles[2 * BOARD_SIZE + 4] = make_tile(L_BEETLE, 2);
-    board->stack[0].location = 2 * BOARD_SIZE + 4;
-    board->stack[0].z = 0;
-    board->stack[0].type = make_tile(D_ANT, 3);
-    board->stack[1].location = 2 * BOARD_SIZE + 4;
-    board->stack[1].z = 1;
-    board->stack[1].type = make_tile(D_BEETLE, 2);
-    board->tiles[2 * BOARD_SIZE + 7] = make_tile(L_ANT, 2);
-
-    board->tiles[3 * BOARD_SIZE + 3] = make_tile(L_BEETLE, 1);
-    board->stack[2].location = 3 * BOARD_SIZE + 3;
-    board->stack[2].z = 0;
-    board->stack[2].type = make_tile(D_GRASSHOPPER, 1);
-    board->stack[3].location = 3 * BOARD_SIZE + 3;
-    board->stack[3].z = 1;
-    board->stack[3].type = make_tile(D_BEETLE, 1);
-    board->tiles[3 * BOARD_SIZE + 7] = make_tile(L_ANT, 1);
-
-    board->tiles[4 * BOARD_SIZE + 7] = make_tile(D_QUEEN, 1);
-
-    board->n_stacked = 4;
-}
-
-void puzzle_11(struct node* tree) {
-    int white_to_move = 0;
+            board = init_board();
+            // The puzzles are mid-game positions, the turn only decides who is to move.
+            board->turn = strcmp(to_move, "light") == 0 ? 10 : 9;
+            continue;
+        }
 
-    struct board* board = tree->board;
+        if (strcmp(word, "end") == 0) {
+            set_board_information(board);
+            translate_board(board);
+            full_update(board);
+            hash_board(board);
 
-    board->turn = white_to_move + 9;
+            puzzle->board = board;
+            return 1;
+        }
 
-    board->tiles[3 * BOARD_SIZE + 3] = make_tile(L_ANT, 1);
-    board->tiles[1 * BOARD_SIZE + 1] = make_tile(D_SPIDER, 2);
-    board->tiles[3 * BOARD_SIZE + 4] = make_tile(L_BEETLE, 2);
-    board->tiles[4 * BOARD_SIZE + 5] = make_tile(L_ANT, 3);
-    board->tiles[5 * BOARD_SIZE + 6] = make_tile(D_ANT, 1);
-    board->tiles[2 * BOARD_SIZE + 3] = make_tile(D_QUEEN, 1);
-    board->tiles[1 * BOARD_SIZE + 2] = make_tile(L_GRASSHOPPER, 2);
-    board->tiles[2 * BOARD_SIZE + 4] = make_tile(L_BEETLE, 1);
-    board->tiles[1 * BOARD_SIZE + 3] = make_tile(L_SPIDER, 1);
-    board->tiles[3 * BOARD_SIZE + 6] = make_tile(D_GRASSHOPPER, 2);
-    board->tiles[2 * BOARD_SIZE + 5] = make_tile(L_GRASSHOPPER, 3);
-    board->tiles[0 * BOARD_SIZE + 3] = make_tile(D_GRASSHOPPER, 1);
-    board->tiles[3 * BOARD_SIZE + 2] = make_tile(D_BEETLE, 1);
-    board->stack[0].location = 3 * BOARD_SIZE + 2;
-    board->stack[0].z = 0;
-    board->stack[0].type = make_tile(L_GRASSHOPPER, 1);
-    board->tiles[2 * BOARD_SIZE + 1] = make_tile(L_QUEEN, 1);
-    board->tiles[1 * BOARD_SIZE + 0] = make_tile(D_GRASSHOPPER, 3);
-    board->tiles[3 * BOARD_SIZE + 1] = make_tile(D_ANT, 2);
-    board->tiles[4 * BOARD_SIZE + 2] = make_tile(L_ANT, 2);
-    board->tiles[5 * BOARD_SIZE + 3] = make_tile(D_SPIDER, 1);
-    board->tiles[2 * BOARD_SIZE + 0] = make_tile(D_BEETLE, 2);
+        int row, column;
+        if (sscanf(line, "%d %d %n", &row, &column, &offset) != 2
+            || row < 0 || row >= BOARD_SIZE || column < 0 || column >= BOARD_SIZE
+            || !place_tiles(board, row * BOARD_SIZE + column, line + offset)) {
+            fprintf(stderr, "Invalid tiles in puzzle %s: %s\n", puzzle->name, line);
+            free(board);
+            return -1;
+        }
+    }
 
-    board->n_stacked = 1;
+    if (board != NULL) {
+        fprintf(stderr, "Puzzle %s is not closed with 'end'.\n", puzzle->name);
+        free(board);
+        return -1;
+    }
+    return 0;
 }
 
-void puzzle_13(struct node* tree) {
-    int white_to_move = 0;
-
-    struct board* board = tree->board;
-
-    board->turn = white_to_move + 9;
-    board->tiles[4 * BOARD_SIZE + 4] = make_tile(D_GRASSHOPPER, 1);
-    board->tiles[5 * BOARD_SIZE + 5] = make_tile(D_QUEEN, 1);
-    board->tiles[6 * BOARD_SIZE + 6] = make_tile(L_SPIDER, 2);
-    board->tiles[2 * BOARD_SIZE + 2] = make_tile(D_ANT, 3);
-    board->tiles[1 * BOARD_SIZE + 1] = make_tile(D_BEETLE, 1);
-    board->tiles[0 * BOARD_SIZE + 0] = make_tile(L_ANT, 3);
-    board->tiles[3 * BOARD_SIZE + 4] = make_tile(L_GRASSHOPPER, 1);
-    board->tiles[5 * BOARD_SIZE + 6] = make_tile(L_BEETLE, 2);
-    board->stack[0].location = 5 * BOARD_SIZE + 6;
-    board->stack[0].z = 0;
-    board->stack[0].type = make_tile(L_BEETLE, 1);
-    board->tiles[0 * BOARD_SIZE + 1] = make_tile(L_ANT, 2);
-    board->tiles[3 * BOARD_SIZE + 5] = make_tile(L_SPIDER, 1);
-    board->tiles[2 * BOARD_SIZE + 5] = make_tile(D_ANT, 2);
-    board->tiles[1 * BOARD_SIZE + 4] = make_tile(D_SPIDER, 1);
-    board->tiles[1 * BOARD_SIZE + 5] = make_tile(L_GRASSHOPPER, 2);
-    board->tiles[3 * BOARD_SIZE + 2] = make_tile(D_BEETLE, 2);
-    board->stack[1].location = 3 * BOARD_SIZE + 2;
-    board->stack[1].z = 0;
-    board->stack[1].type = make_tile(L_QUEEN, 1);
-    board->tiles[4 * BOARD_SIZE + 3] = make_tile(D_ANT, 1);
-    board->tiles[2 * BOARD_SIZE + 1] = make_tile(D_GRASSHOPPER, 2);
-    board->tiles[4 * BOARD_SIZE + 2] = make_tile(L_ANT, 1);
-    board->tiles[4 * BOARD_SIZE + 1] = make_tile(D_GRASSHOPPER, 3);
-
-    board->n_stacked = 2;
-}
+/*
+ * Replaces the board of the tree with the puzzle of the given name from a puzzle file.
+ */
+void setup_puzzle(struct node** tree, const char* path, const char* name) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open puzzle file '%s'.\n", path);
+        exit(1);
+    }
 
-void setup_puzzle(struct node** tree, int puzzle_number) {
-    struct board* board = (*tree)->board;
-    memset(board->tiles, 0, sizeof(board->tiles));
-    board->zobrist_hash = 0;
-    board->n_children = 0;
+    struct puzzle puzzle;
+    int result;
+    while ((result = read_puzzle(file, &puzzle)) == 1) {
+        if (strcmp(puzzle.name, name) == 0) break;
+        free(puzzle.board);
+    }
+    fclose(file);
 
-    if (puzzle_number == 4) {
-        puzzle_4(*tree);
-    } else if (puzzle_number == 5) {
-        puzzle_5(*tree);
-    } else if (puzzle_number == 10) {
-        puzzle_10(*tree);
-    } else if (puzzle_number == 11) {
-        puzzle_11(*tree);
-    } else {
-        fprintf(stderr, "Invalid puzzle number supplied.");
+    if (result != 1) {
+        fprintf(stderr, "Invalid puzzle name supplied.\n");
         exit(1);
     }
 
-    set_board_information(board);
-    translate_board(board);
-    full_update(board);
-}
\ No newline at end of file
+    free((*tree)->board);
+    (*tree)->board = puzzle.board;
+}
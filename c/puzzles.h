@@ -5,6 +5,19 @@
 #ifndef HIVE_PUZZLES_H
 #define HIVE_PUZZLES_H
 
-void setup_puzzle(struct node** tree, int puzzle_number);
+#include <stdio.h>
+#include "engine/node.h"
+
+#define PUZZLE_NAME_LENGTH 32
+
+struct puzzle {
+    char name[PUZZLE_NAME_LENGTH];
+    // Amount of plies in which the player to move can force a win (mate in N is 2N - 1 plies).
+    int plies;
+    struct board* board;
+};
+
+int read_puzzle(FILE* file, struct puzzle* puzzle);
+void setup_puzzle(struct node** tree, const char* path, const char* name);
 
 #endif //HIVE_PUZZLES_H
@@ -0,0 +1,176 @@
+//
+// Runs a solver on the tactical puzzles in puzzles.txt, as a benchmark of search efficiency next to perft.
+//
+
+#include <utils.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <time.h>
+#include <moves.h>
+#include <omp.h>
+#include <tt.h>
+#include "mm/mm.h"
+#include "mm/ordering.h"
+#include "mcts/mcts.h"
+#include "pns/dfpn.h"
+#include "puzzles.h"
+
+#ifndef PUZZLE_FILE
+#define PUZZLE_FILE "puzzles.txt"
+#endif
+
+#define SOLVER_MM 0
+#define SOLVER_MCTS 1
+#define SOLVER_PNS 2
+
+// Minimax search options, to compare their node counts.
+bool pvs = false, aspiration = false;
+
+double cpu_time() {
+    struct timespec cur_time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cur_time);
+    return to_usec(cur_time) / 1e6;
+}
+
+/*
+ * Empties every table the solvers keep between searches, so the result of a puzzle does not depend on the puzzles
+ *  before it.
+ */
+void clear_tables() {
+    tt_clear();
+    ordering_clear();
+    eval_cache_clear();
+    dfpn_clear();
+}
+
+/*
+ * Searches the puzzle with the given solver, returns true if it found a forced win of the player to move within the
+ *  plies of the puzzle, so every solver is held to the same depth.
+ */
+bool solve(struct node* tree, struct puzzle* puzzle, int solver, double time_budget) {
+    int win = tree->board->turn % 2 == 0 ? 1 : 2;
+
+    struct player_arguments args = {0};
+    args.time_to_move = time_budget;
+    args.mcts_constant = 1.41;
+    args.evaluation_function = EVAL_VARIABLE;
+
+    if (solver == SOLVER_PNS) {
+        return dfpn_solve(tree->board, cpu_time() + time_budget, puzzle->plies) == win;
+    }
+
+    if (solver == SOLVER_MCTS) {
+        args.algorithm = ALG_MCTS;
+        args.mcts_solver = true;
+        args.solver_depth = puzzle->plies;
+        mcts(tree, &args);
+        struct mcts_data* data = tree->data;
+        return data->solved == win && data->solved_plies <= puzzle->plies;
+    }
+
+    args.algorithm = ALG_MM;
+    args.pvs = pvs;
+    args.aspiration = aspiration;
+    struct node* best = minimax(tree, &args);
+    float value = ((struct mm_data*) best->data)->mm_value;
+    if (win == 1 ? value <= MM_INFINITY - MAX_TURNS : value >= -MM_INFINITY + MAX_TURNS) return false;
+
+    // A won board scores MM_INFINITY minus the turn it was won in.
+    int plies = (int) (MM_INFINITY - fabsf(value)) - tree->board->turn;
+    return plies <= puzzle->plies;
+}
+
+int main(int argc, char** argv) {
+    char* path = PUZZLE_FILE;
+    int solver = SOLVER_PNS;
+    double time_budget = 10.;
+
+    int c;
+    while ((c = getopt(argc, argv, "f:s:t:n:pw")) != -1) {
+        switch (c) {
+            case 'f':
+                path = optarg;
+                break;
+            case 's':
+                if (strcmp(optarg, "mm") == 0) {
+                    solver = SOLVER_MM;
+                } else if (strcmp(optarg, "mcts") == 0) {
+                    solver = SOLVER_MCTS;
+                } else if (strcmp(optarg, "pns") == 0) {
+                    solver = SOLVER_PNS;
+                } else {
+                    fprintf(stderr, "Unknown solver '%s'.\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 't':
+                time_budget = atof(optarg);
+                break;
+            case 'n':
+                max_expansions = strtoull(optarg, NULL, 10);
+                break;
+            case 'p':
+                pvs = true;
+                break;
+            case 'w':
+                aspiration = true;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-f puzzle file] [-s mm|mcts|pns] [-t seconds] [-n nodes] [-p] [-w] [names...]\n",
+                        argv[0]);
+                exit(1);
+        }
+    }
+
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open puzzle file '%s'.\n", path);
+        exit(1);
+    }
+    omp_set_num_threads(1);
+    dfpn_init();
+
+    printf("Running the %s solver with a budget of %.2f seconds and %llu nodes (0 is unlimited).\n",
+           solver == SOLVER_MM ? "mm" : (solver == SOLVER_MCTS ? "mcts" : "pns"), time_budget, max_expansions);
+    printf("Puzzle   | Plies | Result   | Time (s)        | Nodes           | Knodes/sec    \n");
+    printf("---------|-------|----------|-----------------|-----------------|--------------\n");
+
+    struct puzzle puzzle;
+    int result, n_puzzles = 0, n_solved = 0;
+    while ((result = read_puzzle(file, &puzzle)) == 1) {
+        // Only run the puzzles named on the command line, if there are any.
+        bool selected = optind == argc;
+        for (int i = optind; i < argc; i++) {
+            if (strcmp(argv[i], puzzle.name) == 0) selected = true;
+        }
+        if (!selected) {
+            free(puzzle.board);
+            continue;
+        }
+
+        dedicated_add_child = mcts_add_child;
+        dedicated_init = mcts_init;
+        struct node* tree = game_init();
+        free(tree->board);
+        tree->board = puzzle.board;
+
+        clear_tables();
+        n_expansions = 0;
+        double start = cpu_time();
+        bool solved = solve(tree, &puzzle, solver, time_budget);
+        double time = cpu_time() - start;
+
+        n_puzzles++;
+        n_solved += solved;
+        printf("%-8s | %5d | %-8s | %15.4f | %15llu | (%.2f)\n", puzzle.name, puzzle.plies,
+               solved ? "solved" : "unsolved", time, n_expansions, (n_expansions / time) / 1000);
+        node_free(tree);
+    }
+    fclose(file);
+
+    printf("Solved %d/%d puzzles.\n", n_solved, n_puzzles);
+    return result == -1;
+}
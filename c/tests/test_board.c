@@ -0,0 +1,76 @@
+//
+// Regression checks of the board hashing and symmetries, on the positions of random games.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include "engine/node.h"
+#include "engine/moves.h"
+#include "engine/tt.h"
+#include "engine/utils.h"
+
+#define N_GAMES 100
+
+/*
+ * The incremental hash of the board should be the hash computed from scratch.
+ */
+static int check_hash(struct board *board) {
+    struct board copy;
+    memcpy(&copy, board, sizeof(struct board));
+    hash_board(&copy);
+    return copy.zobrist_hash != board->zobrist_hash;
+}
+
+/*
+ * Every rotation and reflection of the board should have the same canonical form and canonical hash.
+ */
+static int check_symmetries(struct board *board) {
+    struct packed_position packed, canonical;
+    board_pack(board, &packed);
+    board_canonical(board, &canonical);
+    int64_t hash = zobrist_canonical(board);
+
+    for (int symmetry = 0; symmetry < N_SYMMETRIES; symmetry++) {
+        struct packed_position transformed, other;
+        packed_transform(&packed, symmetry, &transformed);
+
+        struct board symmetric;
+        board_unpack(&symmetric, &transformed);
+        board_canonical(&symmetric, &other);
+        if (memcmp(&canonical, &other, sizeof(struct packed_position)) != 0) return 1;
+        if (zobrist_canonical(&symmetric) != hash) return 1;
+    }
+    return 0;
+}
+
+int main() {
+    struct rng rng;
+    rng_seed(&rng, 7);
+
+    int n_positions = 0, hash_errors = 0, symmetry_errors = 0;
+    for (int game = 0; game < N_GAMES; game++) {
+        struct node *root = game_init();
+        struct node *node = root;
+        while (finished_board(node->board) == 0) {
+            generate_children(node, (double) INT_MAX, 0);
+            if (node->board->n_children == 0) break;
+
+            int choice = (int) rng_below(&rng, node->board->n_children), n = 0;
+            struct list *head;
+            node_foreach(node, head) {
+                if (n++ == choice) break;
+            }
+            node = container_of(head, struct node, node);
+
+            n_positions++;
+            hash_errors += check_hash(node->board);
+            symmetry_errors += check_symmetries(node->board);
+        }
+        node_free(root);
+    }
+
+    printf("Checked %d positions: %d incremental hash errors, %d symmetry errors.\n", n_positions, hash_errors,
+           symmetry_errors);
+    return hash_errors != 0 || symmetry_errors != 0;
+}
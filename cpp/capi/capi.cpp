@@ -0,0 +1,197 @@
+
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include "tree_impl.cpp"
+#include "tt.h"
+#include "utils.h"
+#include "capi.h"
+
+/*
+ * Board dimensions, under the same names as in the C engine library.
+ */
+unsigned int pboardsize = BOARD_SIZE;
+unsigned int ptilestacksize = TILE_STACK_SIZE;
+unsigned int pmaxturns = MAX_TURNS - 1;
+unsigned int pnplanes = N_PLANES;
+
+namespace {
+    using Node = BaseNode<DefaultData>;
+
+    Node *to_node(hive_node *node) { return reinterpret_cast<Node *>(node); }
+
+    hive_node *to_handle(Node *node) { return reinterpret_cast<hive_node *>(node); }
+
+    double cpu_time() {
+        struct timespec cur_time{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cur_time);
+        return to_usec(cur_time) / 1e6;
+    }
+
+    int flat_location(const Position &position) {
+        return position.x == -1 ? -1 : position.flat_index();
+    }
+
+    /*
+     * Returns a copy of the node without its children, owned by the caller.
+     */
+    Node *detached_copy(const Node &node) {
+        Node *copy = new Node(node.copy());
+        copy->parent = nullptr;
+        return copy;
+    }
+
+    void engine_init() {
+        // Initialize zobrist hashing table
+        if (zobrist_table == nullptr)
+            zobrist_init();
+        if (tt_table == nullptr) {
+            // Initialize transposition table (set flag to -1 to know if its empty)
+            tt_init();
+        }
+    }
+
+    static_assert(sizeof(hive_packed_position) == sizeof(packed_position), "Both packed positions have 32 bytes");
+}
+
+hive_node *game_init() {
+    engine_init();
+
+    Node *root = new Node();
+    root->board.initialize();
+    return to_handle(root);
+}
+
+hive_node *node_from_packed(const struct hive_packed_position *packed) {
+    engine_init();
+
+    packed_position position{};
+    memcpy(position.bits, packed->bits, sizeof(position.bits));
+
+    Node *root = new Node();
+    root->board.unpack(position);
+    return to_handle(root);
+}
+
+void node_pack(hive_node *handle, struct hive_packed_position *packed) {
+    packed_position position{};
+    to_node(handle)->board.pack(position);
+    memcpy(packed->bits, position.bits, sizeof(packed->bits));
+}
+
+void node_planes(hive_node *handle, int player, uint8_t *planes) {
+    to_node(handle)->board.to_planes(planes, player);
+}
+
+int generate_children(hive_node *handle, double end_time, int flags) {
+    /*
+     * Returns 0 if nothing went wrong, an error-code otherwise
+     *   1: No more moves could be generated due to turn limit.
+     *   2: Time-budget is spent.
+     * With one of the MOVE_PARTIAL flags only part of the moves is generated, and 1 is returned if that part is empty.
+     */
+    if (cpu_time() > end_time) return ERR_NOTIME;
+
+    return to_node(handle)->generate_children(flags);
+}
+
+int encode_move(const struct hive_move *move, int encoding) {
+    Move m{};
+    m.tile = move->tile;
+    m.next_to = move->next_to;
+    m.direction = move->direction;
+    m.location = move->location == -1 ? Position(-1, -1)
+                                       : Position(move->location % BOARD_SIZE, move->location / BOARD_SIZE);
+    return m.encode(encoding);
+}
+
+int generate_children_batch(hive_node *handle, double end_time, hive_node **out_children,
+                            struct hive_move *out_moves, int *out_encodings, int encoding, uint8_t *out_planes,
+                            int max_children) {
+    /*
+     * Generates the children if there are none yet, and writes up to max_children of them at once.
+     * Returns the amount of children written, or the error-code of generate_children negated.
+     */
+    Node &node = *to_node(handle);
+    if (node.children.empty()) {
+        int err = generate_children(handle, end_time, 0);
+        if (err) return -err;
+    }
+
+    int n = 0;
+    for (Node &child : node.children) {
+        if (n == max_children) break;
+
+        if (out_children != nullptr) out_children[n] = to_handle(&child);
+        if (out_moves != nullptr) node_get_move(to_handle(&child), &out_moves[n]);
+        if (out_encodings != nullptr) out_encodings[n] = child.move.encode(encoding);
+        if (out_planes != nullptr) {
+            child.board.to_planes(&out_planes[n * N_PLANES * BOARD_SIZE * BOARD_SIZE], child.board.turn % 2);
+        }
+        n++;
+    }
+    return n;
+}
+
+int finished_board(hive_node *handle) {
+    return to_node(handle)->board.finished();
+}
+
+void node_free_children(hive_node *handle) {
+    to_node(handle)->children.clear();
+}
+
+void node_free(hive_node *handle) {
+    delete to_node(handle);
+}
+
+hive_node *node_copy(hive_node *handle) {
+    return to_handle(detached_copy(*to_node(handle)));
+}
+
+hive_node *node_take_child(hive_node *handle, hive_node *child_handle) {
+    Node &node = *to_node(handle);
+    Node *child = to_node(child_handle);
+
+    bool found = false;
+    for (Node &c : node.children) found |= &c == child;
+    if (!found) return nullptr;
+
+    // The grandchildren are moved over, so the subtree below the child is kept.
+    Node *kept = detached_copy(*child);
+    kept->children.swap(child->children);
+    for (Node &grandchild : kept->children) grandchild.parent = kept;
+
+    node.children.clear();
+    return to_handle(kept);
+}
+
+int node_get_children(hive_node *handle, hive_node **children, int max_children) {
+    int n = 0;
+    for (Node &child : to_node(handle)->children) {
+        if (n == max_children) break;
+        children[n++] = to_handle(&child);
+    }
+    return n;
+}
+
+int node_turn(hive_node *handle) {
+    return to_node(handle)->board.turn;
+}
+
+void node_get_move(hive_node *handle, struct hive_move *move) {
+    Move &m = to_node(handle)->move;
+    move->tile = m.tile;
+    move->next_to = m.next_to;
+    move->direction = m.direction;
+    move->previous_location = flat_location(m.previous_location);
+    move->location = flat_location(m.location);
+}
+
+const uint8_t *node_tiles(hive_node *handle) {
+    return &to_node(handle)->board.tiles[0][0];
+}
+
+void print_board(hive_node *handle) {
+    std::cout << to_node(handle)->board.to_string();
+}
@@ -0,0 +1,113 @@
+
+#ifndef BEEKEEPER_CAPI_H
+#define BEEKEEPER_CAPI_H
+
+/*
+ * C interface to the C++ engine core, which the Python package uses instead of the C engine library (libhive.so)
+ *  with Hive.core set to "cxx", see games/hive/hive.py.
+ * Nodes are opaque handles, so their contents are read through the node_* functions below. Positions are exchanged
+ *  with the C engine as packed positions, which both engines read and write in the same layout. The searches
+ *  (mcts and minimax) stay in the C engine; the Python package unpacks the position there, and plays the child with
+ *  the packed position of the move the search chose.
+ * All structs use the natural (unpacked) alignment.
+ *
+ * Ownership:
+ *  - Nodes returned by game_init, node_from_packed, node_copy and node_take_child are owned by the caller, and must be
+ *     released with node_free.
+ *  - Nodes returned by node_get_children and generate_children_batch are owned by their parent, they stay valid until
+ *     node_free_children, node_take_child or node_free is called on that parent.
+ */
+
+#ifdef __cplusplus
+#include <cstdint>
+extern "C" {
+#else
+#include <stdbool.h>
+#include <stdint.h>
+#endif
+
+typedef struct hive_node hive_node;
+
+// Move encodings of the policy networks, see encode_move.
+#define ENCODING_ABSOLUTE 0
+#define ENCODING_RELATIVE 1
+
+// Flags of generate_children to generate only part of the moves, see generate_children.
+#define MOVE_NO_ANTS (1 << 0)
+#define MOVE_NO_SPIDERS (1 << 1)
+#define MOVE_ONLY_ANTS_SPIDERS (1 << 2)
+#define MOVE_PARTIAL (MOVE_NO_ANTS | MOVE_NO_SPIDERS | MOVE_ONLY_ANTS_SPIDERS)
+
+/*
+ * Move leading to a node, locations are flat indices (y * BOARD_SIZE + x) or -1 if there is none.
+ */
+struct hive_move {
+    unsigned char tile;
+    unsigned char next_to;
+    unsigned char direction;
+    int previous_location;
+    int location;
+};
+
+/*
+ * A position in 32 bytes, the same layout as struct packed_position of both engines (see engine/board.h).
+ */
+struct hive_packed_position {
+    uint64_t bits[4];
+};
+
+extern unsigned int pboardsize;
+extern unsigned int ptilestacksize;
+extern unsigned int pmaxturns;
+extern unsigned int pnplanes;
+
+hive_node *game_init();
+
+/*
+ * Generates the children of the node if it has none yet. Returns 0, or ERR_NOMOVES (1) at the turn limit, ERR_NOTIME (2)
+ *  past end_time, in cpu seconds of the thread. With one of the MOVE_PARTIAL flags only part of the moves is generated,
+ *  and 1 is also returned if that part is empty, as in the staged generation of the C engine.
+ */
+int generate_children(hive_node *node, double end_time, int flags);
+int finished_board(hive_node *node);
+
+/*
+ * Generates the children if there are none yet, and writes up to max_children of them in one call; their handles,
+ *  moves, move encodings and pnplanes feature planes of pboardsize * pboardsize per child. Plane i marks the tile
+ *  with to_tile_index i + 1 where it is on top, the last plane holds the player to move in the child.
+ * Any of the buffers can be NULL to skip it. The children stay owned by the node, as with node_get_children.
+ * Returns the amount of children written, or the error-code of generate_children negated.
+ */
+int generate_children_batch(hive_node *node, double end_time, hive_node **out_children, struct hive_move *out_moves,
+                            int *out_encodings, int encoding, uint8_t *out_planes, int max_children);
+int encode_move(const struct hive_move *move, int encoding);
+
+void node_free_children(hive_node *node);
+void node_free(hive_node *node);
+hive_node *node_copy(hive_node *node);
+/*
+ * Returns the child as a node owned by the caller, with its own children, and frees the other children of the node.
+ * Returns NULL if it is not a child of the node.
+ */
+hive_node *node_take_child(hive_node *node, hive_node *child);
+
+hive_node *node_from_packed(const struct hive_packed_position *packed);
+void node_pack(hive_node *node, struct hive_packed_position *packed);
+/*
+ * Writes the pnplanes feature planes of the node, as generate_children_batch does for the children, the last plane
+ *  holding the given player.
+ */
+void node_planes(hive_node *node, int player, uint8_t *planes);
+
+int node_get_children(hive_node *node, hive_node **children, int max_children);
+int node_turn(hive_node *node);
+void node_get_move(hive_node *node, struct hive_move *move);
+const uint8_t *node_tiles(hive_node *node);
+
+void print_board(hive_node *node);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //BEEKEEPER_CAPI_H
@@ -2,13 +2,14 @@
 #include <cstring>
 #include <list>
 #include "board.h"
+#include "tt.h"
 
 int Board::finished() {
     int res = UNDECIDED;
     if (light_queen.x != -1) {
-        // Check queen 1
+        // Check queen 1, a surrounded light queen means dark won.
         if (is_surrounded(light_queen)) {
-            res = LIGHT_WON;
+            res = DARK_WON;
         }
     }
 
@@ -16,19 +17,13 @@ int Board::finished() {
         // Check queen 2
         if (is_surrounded(dark_queen)) {
             if (res == 0)
-                res = DARK_WON;
+                res = LIGHT_WON;
             else
                 res = DRAW;
         }
     }
 
-    // Check draw by repetition.
-//    int sum = 0;
-//    for (int i = 0; i < board->turn; i++) {
-//        if (board->hash_history[i] == board->zobrist_hash) sum++;
-//
-//        if (sum == 3) res = 3;
-//    }
+    // A draw by repetition depends on the game, not only the board, see hash_history.
 
     // Draw due to turn limit
     // TODO: Set turn limit in game instead of hardcoded
@@ -149,6 +144,7 @@ void Board::center() {
     );
 
     Position translate = Position(dest.x - min.x, dest.y - min.y);
+    zobrist_translate(*this, min, dest);
 
     // Move all the tile tracking structs the same amount as the rest of the board.
     if (light_queen.x != -1) {
@@ -165,6 +161,12 @@ void Board::center() {
             i.position.y += translate.y;
         }
     }
+    for (auto &tile_position : tile_positions) {
+        if (tile_position.x != -1) {
+            tile_position.x += translate.x;
+            tile_position.y += translate.y;
+        }
+    }
 
     size_t dest_begin = dest.flat_index();
 
@@ -199,7 +201,7 @@ void Board::center() {
     );
     std::memset(tiles_dest, 0, dest_begin * sizeof(uint8_t));
 
-    std::memset(tiles_dest + dest_begin + size + 1, 0, sizeof(tiles) - (dest_begin + size - 1));
+    std::memset(tiles_dest + dest_begin + size, 0, sizeof(tiles) - (dest_begin + size));
 
 //// Copy data into temp array
 //    char t[BOARD_SIZE * BOARD_SIZE] = {0};
@@ -243,6 +245,26 @@ bool Board::is_surrounded(Position &position) {
 }
 
 
+void hash_history::push(Board &board) {
+    if (n == 0) first = board.turn;
+    hashes[board.turn] = board.zobrist_hash;
+    n_placed[board.turn] = board.sum_hive_tiles() + board.n_stacked;
+    n = board.turn + 1;
+}
+
+/*
+ * Returns how often the last position occurred before with the same player to move. Only the moves since the last
+ *  placement can lead back to it, so the scan stops there.
+ */
+int hash_history::repetitions() const {
+    int last = n - 1;
+    int count = 0;
+    for (int i = last - 2; i >= first && n_placed[i] == n_placed[last]; i -= 2) {
+        if (hashes[i] == hashes[last]) count++;
+    }
+    return count;
+}
+
 int Board::sum_hive_tiles() {
     return N_TILES * 2 - (
             players[0].queens_left +
@@ -288,7 +310,7 @@ Board::tile_stack *Board::get_from_stack(const Position &position, bool pop) {
 
 void Board::initialize() {
     memset(tiles, 0, sizeof(tiles));
-    memset(free, 0, sizeof(free));
+    free.reset();
 
     turn = 0;
 
@@ -303,9 +325,17 @@ void Board::initialize() {
 
     n_stacked = 0;
 
-    memset(stack, 0, sizeof(stack));
+    // Empty stack entries are marked with a position of -1.
+    for (auto &ts : stack) {
+        ts = {EMPTY, 0, Position(-1, -1)};
+    }
+
+    for (auto &tile_position : tile_positions) {
+        tile_position = Position(-1, -1);
+    }
 
     zobrist_hash = 0;
+    zobrist_sum = 0;
 //    std::vector<long long> hash_history = std::vector<long long>();
 
     has_updated = false;
@@ -346,24 +376,11 @@ bool Board::can_move(Position &position) {
 
 
 void Board::update_free_tiles() {
-    int n_updated = 0;
-    int to_update = sum_hive_tiles();
-    Position pos;
-    for (int x = min.x; x < max.x + 1; x++) {
-        if (n_updated == to_update) break;
-
-        for (int y = min.y; y < max.y + 1; y++) {
-            if (n_updated == to_update) break;
-
-            // Dont check empty tiles, or tiles which could already move before this.
-            if (tiles[y][x] == EMPTY) continue;
-
-            // Allow everything at first, then let articulation fix this.
-            n_updated++;
+    for (Position &position : tile_positions) {
+        // Covered tiles share their location with the top of the stack, which is updated anyway.
+        if (position.x == -1) continue;
 
-            pos = Position(x, y);
-            free[y][x] = can_move(pos);
-        }
+        free[position.flat_index()] = can_move(position);
     }
 
 //    print_board(board);
@@ -420,6 +437,152 @@ void Board::update_can_move(Position &position, Position &previous_position) {
 }
 
 
+/*
+ * Fills N_PLANES planes of BOARD_SIZE * BOARD_SIZE, plane i marks the location of the tile with to_tile_index i + 1
+ *  if it is on top. The last plane is filled with the player.
+ */
+void Board::to_planes(uint8_t *planes, int player) {
+    const int plane_size = BOARD_SIZE * BOARD_SIZE;
+    std::fill(planes, planes + N_TILES * 2 * plane_size, 0);
+    for (int i = 0; i < N_TILES * 2; i++) {
+        Position &position = tile_positions[i];
+        if (position.x == -1) continue;
+
+        uint8_t top = tiles[position.y][position.x];
+        if (top == EMPTY || tile_position_index(top) != i) continue;
+        planes[i * plane_size + position.flat_index()] = 1;
+    }
+    std::fill(planes + N_TILES * 2 * plane_size, planes + N_PLANES * plane_size, player);
+}
+
+// The words of a packed position, a field crossing into the next word never writes past the last one.
+constexpr int PACKED_WORDS = 4;
+static_assert(sizeof(packed_position) == PACKED_WORDS * sizeof(uint64_t), "Packed positions are 4 words");
+static_assert(PACKED_BEETLES_OFFSET + N_BEETLES * 2 * 3 <= PACKED_TURN_OFFSET
+              && PACKED_TURN_OFFSET + 16 <= PACKED_WORDS * 64, "The packed fields overlap or overflow");
+
+static void put_bits(uint64_t *bits, int offset, int n, uint64_t value) {
+    bits[offset / 64] |= value << (offset % 64);
+    if (offset % 64 + n > 64 && offset / 64 + 1 < PACKED_WORDS)
+        bits[offset / 64 + 1] |= value >> (64 - offset % 64);
+}
+
+static uint64_t get_bits(const uint64_t *bits, int offset, int n) {
+    uint64_t value = bits[offset / 64] >> (offset % 64);
+    if (offset % 64 + n > 64 && offset / 64 + 1 < PACKED_WORDS)
+        value |= bits[offset / 64 + 1] << (64 - offset % 64);
+    return value & ((1ull << n) - 1);
+}
+
+/*
+ * Index in Board::tile_positions of the given beetle (0 to N_BEETLES * 2 - 1).
+ */
+static int beetle_index(int beetle) {
+    int color = beetle / N_BEETLES;
+    int number = beetle % N_BEETLES + 1;
+    return tile_position_index((color << COLOR_SHIFT) | L_BEETLE | (number << NUMBER_SHIFT));
+}
+
+void Board::pack(packed_position &packed) {
+    packed = {};
+
+    Position lowest(BOARD_SIZE, BOARD_SIZE);
+    for (Position &position : tile_positions) {
+        if (position.x == -1) continue;
+        lowest.x = std::min(lowest.x, position.x);
+        lowest.y = std::min(lowest.y, position.y);
+    }
+    for (int i = 0; i < N_TILES * 2; i++) {
+        Position &position = tile_positions[i];
+        int field = PACKED_NOT_PLACED;
+        if (position.x != -1) field = (position.x - lowest.x) | (position.y - lowest.y) << 5;
+        put_bits(packed.bits, i * 10, 10, field);
+    }
+
+    // Only beetles can be on top of other tiles, so they are the only tiles which are not on the ground.
+    for (int b = 0; b < N_BEETLES * 2; b++) {
+        int idx = beetle_index(b);
+        Position &position = tile_positions[idx];
+        if (position.x == -1) continue;
+
+        bool on_top = tile_position_index((*this)[position]) == idx;
+        int z = 0;
+        for (tile_stack &ts : stack) {
+            if (ts.position != position) continue;
+
+            if (!on_top) {
+                if (tile_position_index(ts.type) == idx) z = ts.z;
+            } else {
+                // The beetle on top is above all covered tiles.
+                z++;
+            }
+        }
+        put_bits(packed.bits, PACKED_BEETLES_OFFSET + b * 3, 3, z);
+    }
+    put_bits(packed.bits, PACKED_TURN_OFFSET, 16, turn);
+}
+
+/*
+ * Sets up the board from a packed position, with the hive centered as center() would.
+ */
+void Board::unpack(const packed_position &packed) {
+    initialize();
+    turn = int32_t(get_bits(packed.bits, PACKED_TURN_OFFSET, 16));
+
+    int x[N_TILES * 2], y[N_TILES * 2], z[N_TILES * 2] = {0};
+    int width = 0, height = 0;
+    for (int i = 0; i < N_TILES * 2; i++) {
+        int field = int(get_bits(packed.bits, i * 10, 10));
+        x[i] = field == PACKED_NOT_PLACED ? -1 : field & 31;
+        y[i] = field >> 5;
+        if (x[i] == -1) continue;
+
+        width = std::max(width, x[i] + 1);
+        height = std::max(height, y[i] + 1);
+    }
+    for (int b = 0; b < N_BEETLES * 2; b++) {
+        z[beetle_index(b)] = int(get_bits(packed.bits, PACKED_BEETLES_OFFSET + b * 3, 3));
+    }
+
+    Position dest((BOARD_SIZE / 2) - width / 2, (BOARD_SIZE / 2) - height / 2);
+    min = dest;
+    max = Position(dest.x + width - 1, dest.y + height - 1);
+    for (int i = 0; i < N_TILES * 2; i++) {
+        if (x[i] == -1) continue;
+
+        bool covered = false;
+        for (int j = 0; j < N_TILES * 2; j++) {
+            if (x[j] == x[i] && y[j] == y[i] && z[j] > z[i]) covered = true;
+        }
+
+        uint8_t tile = tile_from_position_index(i);
+        Position position(dest.x + x[i], dest.y + y[i]);
+        tile_positions[i] = position;
+        if (covered) {
+            stack[n_stacked++] = {tile, uint8_t(z[i]), position};
+        } else {
+            (*this)[position] = tile;
+        }
+
+        player_info &player = players[(tile & COLOR_MASK) >> COLOR_SHIFT];
+        switch (tile & TILE_MASK) {
+            case L_ANT: player.ants_left--;
+                break;
+            case L_GRASSHOPPER: player.grasshoppers_left--;
+                break;
+            case L_BEETLE: player.beetles_left--;
+                break;
+            case L_SPIDER: player.spiders_left--;
+                break;
+            default: player.queens_left--;
+                if ((tile & COLOR_MASK) == LIGHT) light_queen = position;
+                else dark_queen = position;
+        }
+        ::zobrist_hash(*this, position, Position(-1, -1), tile, z[i], 0);
+    }
+    zobrist_rebase(*this);
+}
+
 int Board::connected_components(Position &original_position) {
     bool visited[BOARD_SIZE][BOARD_SIZE] = {false};
 
@@ -3,14 +3,82 @@
 #define BEEKEEPER_BOARD_H
 
 #include "constants.h"
+#include <bitset>
+#include <type_traits>
 #include <vector>
 #include <string>
 #include "position.h"
 
+/*
+ * Tiles of the same type and colour are stored contiguously in Board::tile_positions,
+ *  in the same order as to_tile_index (ants, grasshoppers, beetles, spiders, queen).
+ */
+constexpr int tile_type_count(int type) {
+    switch (type & TILE_MASK) {
+        case L_ANT: return N_ANTS;
+        case L_GRASSHOPPER: return N_GRASSHOPPERS;
+        case L_BEETLE: return N_BEETLES;
+        case L_SPIDER: return N_SPIDERS;
+        default: return N_QUEENS;
+    }
+}
+
+constexpr int tile_type_offset(int type) {
+    int offset = ((type & COLOR_MASK) >> COLOR_SHIFT) * N_TILES;
+    switch (type & TILE_MASK) {
+        case L_QUEEN: offset += N_SPIDERS;
+            [[fallthrough]];
+        case L_SPIDER: offset += N_BEETLES;
+            [[fallthrough]];
+        case L_BEETLE: offset += N_GRASSHOPPERS;
+            [[fallthrough]];
+        case L_GRASSHOPPER: offset += N_ANTS;
+            [[fallthrough]];
+        default: return offset;
+    }
+}
+
+/*
+ * Index in Board::tile_positions of a numbered tile, this equals to_tile_index - 1.
+ */
+constexpr int tile_position_index(int tile) {
+    return tile_type_offset(tile) + ((tile & NUMBER_MASK) >> NUMBER_SHIFT) - 1;
+}
+
+/*
+ * The numbered tile at an index of Board::tile_positions, the inverse of tile_position_index.
+ */
+constexpr uint8_t tile_from_position_index(int index) {
+    int color = index / N_TILES;
+    int n = index % N_TILES;
+    for (int type : {L_ANT, L_GRASSHOPPER, L_BEETLE, L_SPIDER, L_QUEEN}) {
+        if (n < tile_type_count(type)) return (color << COLOR_SHIFT) | type | ((n + 1) << NUMBER_SHIFT);
+        n -= tile_type_count(type);
+    }
+    return EMPTY;
+}
+
+/*
+ * A position in 32 bytes, the same wherever the hive lies on the board, and the same as struct packed_position of
+ *  the C engine. Every tile (see tile_position_index) has 10 bits with its x and its y shifted by 5, relative to the
+ *  lowest x and y of the hive, or PACKED_NOT_PLACED. The height in a stack of the beetles follows in 3 bits per
+ *  beetle, and the turn takes the last 16 bits.
+ */
+struct packed_position {
+    uint64_t bits[4];
+};
+
+static_assert(sizeof(packed_position) == 32);
+
+#define PACKED_NOT_PLACED 0x3FF
+#define PACKED_BEETLES_OFFSET (N_TILES * 2 * 10)
+#define PACKED_TURN_OFFSET 240
+
 class Board {
 public:
     uint8_t tiles[BOARD_SIZE][BOARD_SIZE];
-    uint8_t free[BOARD_SIZE][BOARD_SIZE];
+    // Whether the tile at a location (Position::flat_index) can move, only kept up to date for the tiles.
+    std::bitset<BOARD_SIZE * BOARD_SIZE> free;
 
     int32_t turn;
 
@@ -36,7 +104,13 @@ public:
         Position position;
     } stack[TILE_STACK_SIZE];
 
+    // Location of every tile (see tile_position_index), x is -1 if the tile is not placed yet.
+    // Tiles covered by a beetle keep the location of their stack.
+    Position tile_positions[N_TILES * 2];
+
+    // Translation invariant hash of the tiles, derived from zobrist_sum (see tt.cpp).
     int64_t zobrist_hash;
+    uint64_t zobrist_sum;
 
     bool has_updated;
 
@@ -61,6 +135,12 @@ public:
 
     void update_can_move(Position &position, Position &previous_position);
 
+    void to_planes(uint8_t *planes, int player);
+
+    void pack(packed_position &packed);
+
+    void unpack(const packed_position &packed);
+
     unsigned char &operator[](Position &position) { return tiles[position.y][position.x]; };
 
 private:
@@ -77,6 +157,29 @@ private:
     int connected_components(Position &position);
 };
 
+// Nodes are copied with their board, so apart from its tiles it only holds a few cache lines.
+static_assert(sizeof(Board) - sizeof(Board::tiles) - sizeof(Board::free) <= 192, "The board state besides its grids grew");
+static_assert(std::is_trivially_copyable<Board>::value, "Boards are copied with memcpy");
+
+/*
+ * Hashes of the positions of a game, kept once per game instead of in every board. The game pushes the positions
+ *  played so far, a search pushes the positions along its path on top and pops them again.
+ * Positions are stored at their turn, from the turn of the first known position up to n.
+ */
+struct hash_history {
+    int first = 0;
+    int n = 0;
+    int64_t hashes[MAX_TURNS + 1];
+    // Tiles placed in every position, a placement cannot be undone so earlier positions never repeat.
+    uint8_t n_placed[MAX_TURNS + 1];
+
+    void push(Board &board);
+
+    void pop() { n--; }
+
+    int repetitions() const;
+};
+
 
 
 #endif //BEEKEEPER_BOARD_H
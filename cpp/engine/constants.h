@@ -40,6 +40,14 @@
 #define MAX_TURNS 1000
 #endif
 
+// Feature planes of a board for the neural networks, one per tile and one holding the player.
+#define N_PLANES (N_TILES * 2 + 1)
+
+// Move encodings of the policy networks, the absolute encoding has a policy of POLICY_SIZE.
+#define ENCODING_ABSOLUTE 0
+#define ENCODING_RELATIVE 1
+#define POLICY_SIZE (N_TILES * BOARD_SIZE * BOARD_SIZE)
+
 #define UNDECIDED 0
 #define LIGHT_WON 1
 #define DARK_WON 2
@@ -52,4 +60,10 @@
 #define ERR_NOTIME 2
 #define ERR_NOMEM 3
 
+// Flags of generate_children to generate only part of the moves, the same as in the C engine.
+#define MOVE_NO_ANTS (1 << 0)
+#define MOVE_NO_SPIDERS (1 << 1)
+#define MOVE_ONLY_ANTS_SPIDERS (1 << 2)
+#define MOVE_PARTIAL (MOVE_NO_ANTS | MOVE_NO_SPIDERS | MOVE_ONLY_ANTS_SPIDERS)
+
 #endif //BEEKEEPER_CONSTANTS_H
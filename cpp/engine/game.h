@@ -4,6 +4,7 @@
 
 #include <csignal>
 
+#include "random.h"
 #include "tree.h"
 #include "tt.h"
 #include "utils.h"
@@ -13,25 +14,24 @@ template<typename T>
 class Game {
 public:
     T root = T();
+    // Generator of the random choices in this game, a seed of 0 gives a random seed.
+    Random rng;
 
-    Game() {
-        unsigned long seed;
+    explicit Game(uint64_t seed = 0) {
         // Initialize zobrist hashing table
         if (zobrist_table == nullptr)
             zobrist_init();
         if (tt_table == nullptr) {
             // Initialize transposition table (set flag to -1 to know if its empty)
             tt_init();
-            seed = mix(clock(), time(nullptr), getpid());
-            // Randomized seed
-            srand(seed);
         }
+        rng.seed(seed != 0 ? seed : mix(clock(), time(nullptr), getpid()));
 
         root.board.initialize();
     }
 
     void random_move() {
-        size_t selection = std::rand() % root.children.size();
+        size_t selection = rng.below(root.children.size());
         for (T &child : root.children) {
             if (selection == 0) {
                 root = child;
@@ -1,5 +1,6 @@
 
 #include "move.h"
+#include "board.h"
 
 
 
@@ -26,6 +27,24 @@ std::string Move::to_string() const {
     return response;
 }
 
+/*
+ * Index of the move in the policy of the networks. The absolute encoding is the tile of the player with the
+ *  location it moves to, the relative encoding is the tile with the tile it moves next to and the direction.
+ * Returns -1 for a pass.
+ */
+int Move::encode(int encoding) const {
+    if (tile == 0) return -1;
+
+    // Only tiles of the player to move, so the colour is left out.
+    int tile_idx = tile_position_index(tile & ~COLOR_MASK);
+
+    if (encoding == ENCODING_RELATIVE) {
+        int next_to_idx = (next_to & TILE_MASK) == EMPTY ? 0 : tile_position_index(next_to) + 1;
+        return (tile_idx * (N_TILES * 2 + 1) + next_to_idx) * 7 + direction;
+    }
+    return tile_idx * BOARD_SIZE * BOARD_SIZE + location.flat_index();
+}
+
 std::string Move::tile_string(uint8_t tile_type) {
     std::string response;
     unsigned char color = tile_type & COLOR_MASK;
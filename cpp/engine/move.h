@@ -18,6 +18,8 @@ public:
 
     [[nodiscard]] std::string to_string() const;
 
+    [[nodiscard]] int encode(int encoding) const;
+
     [[nodiscard]] static std::string tile_string(uint8_t tile_type);
 };
 
@@ -0,0 +1,67 @@
+
+#ifndef BEEKEEPER_RANDOM_H
+#define BEEKEEPER_RANDOM_H
+
+#include <cstdint>
+#include <limits>
+
+/*
+ * Random number generator (xoshiro256**) owned by a single game or search, the same generator as in the C engine.
+ * It is a UniformRandomBitGenerator, so it also works with the distributions of <random>.
+ */
+class Random {
+public:
+    using result_type = uint64_t;
+
+    explicit Random(uint64_t seed = 0) {
+        this->seed(seed);
+    }
+
+    // Expands the seed with splitmix64, which never gives the all-zero state xoshiro cannot leave.
+    void seed(uint64_t seed) {
+        for (uint64_t &s : state) {
+            uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            s = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        uint64_t result = rotate(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotate(state[3], 45);
+        return result;
+    }
+
+    // Uniform integer in [0, n) for n > 0, without the bias of a modulo (Lemire's multiply and reject).
+    uint32_t below(uint32_t n) {
+        uint64_t product = ((*this)() >> 32) * n;
+        if (uint32_t(product) < n) {
+            uint32_t threshold = -n % n;
+            while (uint32_t(product) < threshold) {
+                product = ((*this)() >> 32) * n;
+            }
+        }
+        return uint32_t(product >> 32);
+    }
+
+private:
+    uint64_t state[4];
+
+    static uint64_t rotate(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+#endif //BEEKEEPER_RANDOM_H
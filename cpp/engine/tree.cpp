@@ -12,10 +12,8 @@
  * Generates the placing moves, only allowed to place next to allied tiles.
  */
 template <typename T>
+template <int Color>
 void BaseNode<T>::generate_placing_moves(uint8_t type) {
-
-    uint8_t color = type & COLOR_MASK;
-
     const Position invalid_position = Position(-1, -1);
 
     if (board.turn == 0) {
@@ -29,48 +27,42 @@ void BaseNode<T>::generate_placing_moves(uint8_t type) {
         return;
     }
 
-
-    uint8_t n_encountered = 0;
-    uint8_t to_encounter = board.sum_hive_tiles();
-
     bool is_added[BOARD_SIZE][BOARD_SIZE] = {false};
 
-    for (int8_t y = board.min.y; y < board.max.y + 1; y++) {
-        if (n_encountered == to_encounter) break;
-        for (int8_t x = board.min.x; x < board.max.x + 1; x++) {
-            if (n_encountered == to_encounter) break;
+    // A valid placing position always touches an allied tile, so only the allied tiles have to be checked.
+    constexpr int first = tile_type_offset(Color);
+    for (int i = first; i < first + N_TILES; i++) {
+        const Position &position = board.tile_positions[i];
+        if (position.x == -1) continue;
 
-            // Skip empty tiles
-            if (board.tiles[y][x] == EMPTY) continue;
+        // Only the top of a stack decides the colour of its location.
+        if ((board.tiles[position.y][position.x] & COLOR_MASK) != Color) continue;
 
-            n_encountered++;
-            // Get points around this point
-            auto points = Position::get_points_around(x, y);
-            for (const Position &point: points) {
-                // Check if its empty
-                if (board.tiles[point.y][point.x] != EMPTY or is_added[point.y][point.x]) continue;
+        // Get points around this point
+        for (const Position &point: position.get_points_around()) {
+            // Check if its empty
+            if (board.tiles[point.y][point.x] != EMPTY or is_added[point.y][point.x]) continue;
 
-                is_added[point.y][point.x] = true;
+            is_added[point.y][point.x] = true;
 
-                // Check for all neighbours of this point if its the same colour as the colour of the
-                //  passed tile.
-                bool invalid = false;
-                auto neighbor_points = point.get_points_around();
+            // Check for all neighbours of this point if its the same colour as the colour of the
+            //  passed tile.
+            bool invalid = false;
+            auto neighbor_points = point.get_points_around();
 #pragma unroll
-                for (const Position &np_index : neighbor_points) {
-                    // Check if every tile around it has the same colour as the passed tile colour.
-                    if (board.tiles[np_index.y][np_index.x] != EMPTY
-                        and (board.tiles[np_index.y][np_index.x] & COLOR_MASK) != color) {
-                        invalid = true;
-                        break;
-                    }
+            for (const Position &np_index : neighbor_points) {
+                // Check if every tile around it has the same colour as the passed tile colour.
+                if (board.tiles[np_index.y][np_index.x] != EMPTY
+                    and (board.tiles[np_index.y][np_index.x] & COLOR_MASK) != Color) {
+                    invalid = true;
+                    break;
                 }
+            }
 
-                // If any neighbour of this point is another colour, check another point.
-                if (invalid) continue;
+            // If any neighbour of this point is another colour, check another point.
+            if (invalid) continue;
 
-                add_child<true>(point, type, invalid_position);
-            }
+            add_child<true>(point, type, invalid_position);
         }
     }
 }
@@ -161,43 +153,14 @@ void BaseNode<T>::generate_ant_moves(Position &orig) {
     int tile_type = board[orig];
     board[orig] = EMPTY;
 
-    bool ant_visited[BOARD_SIZE][BOARD_SIZE] = {false};
-    std::list<Position> ant_history;
-    std::list<Position> frontier;
+    Position reachable[REACHABLE_QUEUE_SIZE];
+    int n_reachable = find_reachable(board, orig, -1, reachable);
 
-    ant_visited[orig.y][orig.x] = true;
-    frontier.push_back(orig);
-    Position point;
-    while (!frontier.empty()) {
-        point = frontier.back();
-        frontier.pop_back();
-
-        auto points = point.get_points_around();
-        for (Position &new_point : points) {
-            // Ants cannot stack.
-            if (board[new_point] != EMPTY) continue;
-
-            // Skip this tile if it has no neighbours
-            // Connected hive requirement.
-            if (!has_neighbour(board, new_point)) continue;
-
-            // If this tile cannot fit through the gap, skip the tile.
-            if (!tile_fits(board, point, new_point)) continue;
-
-            // Skip tile if we already added this point.
-            if (ant_visited[new_point.y][new_point.x]) continue;
-
-            ant_visited[new_point.y][new_point.x] = true;
-
-            ant_history.push_back(new_point);
-            frontier.push_back(new_point);
-        }
-    }
     board[orig] = tile_type;
 
     // Generate moves based on these valid ant moves.
-    for (Position &p : ant_history) {
-        add_child<false>(p, tile_type, orig);
+    for (int i = 0; i < n_reachable; i++) {
+        add_child<false>(reachable[i], tile_type, orig);
     }
 }
 
@@ -218,30 +181,11 @@ void BaseNode<T>::generate_queen_moves(Position &orig) {
         board[orig] = temp->type;
     }
 
+    // The queen slides along the tiles around it.
     auto points = orig.get_points_around();
-    for (Position &point : points) {
-        // Get all tiles which are connected to the queen
-        if (board[point] == EMPTY) continue;
-
-
-        if (!tile_fits(board, orig, point)) continue;
-
-        // For all neighbors, if the neighbors neighbors == my neighbors -> valid move.
-        auto neighbor_points = point.get_points_around();
-        for (Position &neighbor_point : neighbor_points) {
-            if (board[neighbor_point] != EMPTY) continue;
-
-            for (Position &double_neighbour : points) {
-                // Skip because neighbours do not match.
-                if (neighbor_point != double_neighbour) continue;
-
-                // Skip this tile if the move from the original orig to this new orig does not fit.
-                if (!tile_fits(board, orig, double_neighbour)) continue;
-
-                // This tile is connected.
-                add_child<false>(neighbor_point, tile_type, orig);
-            }
-        }
+    int directions = crawl_directions[neighbour_mask(board, orig)];
+    for (int d = 0; d < 6; d++) {
+        if (directions & (1 << d)) add_child<false>(points[d], tile_type, orig);
     }
 
     board[orig] = tile_type;
@@ -265,11 +209,10 @@ void BaseNode<T>::generate_beetle_moves(Position &point) {
 
         board[point] = EMPTY;
 
-        for (Position &new_point : points) {
-            // Get all tiles which are connected to the beetle
-            if (board[new_point] == EMPTY) continue;
-
-            add_child<false>(new_point, tile_type, point);
+        // Get all tiles which are connected to the beetle
+        int occupied = neighbour_mask(board, point);
+        for (int d = 0; d < 6; d++) {
+            if (occupied & (1 << d)) add_child<false>(points[d], tile_type, point);
         }
     } else {
         // Beetle on top of something has no restrictions on movement off of the tile.
@@ -288,133 +231,120 @@ void BaseNode<T>::generate_spider_moves(Position &orig) {
     int tile_type = board[orig];
     board[orig] = EMPTY;
 
-    bool spider_visited[BOARD_SIZE][BOARD_SIZE] = {false};
-
-    // Frontier to track multiple points.
-    std::list<Position> frontier;
-    std::list<Position> next_frontier;
-
-    frontier.push_back(orig);
-
-    const size_t SPIDER_WALKING_DISTANCE = 3;
-    for (int iteration = 0; iteration < SPIDER_WALKING_DISTANCE; iteration++) {
-        while (!frontier.empty()) {
-            // Get a point on the frontier
-            Position frontier_point = frontier.back();
-            frontier.pop_back();
-            auto points = frontier_point.get_points_around();
+    Position reachable[REACHABLE_QUEUE_SIZE];
+    int n_reachable = find_reachable(board, orig, SPIDER_STEPS, reachable);
 
-            // Iterate all points surrounding this frontier.
-            // Generate a list containing all valid moves from the frontier onward.
-            for (Position &point : points) {
-                if (board[point] == EMPTY) continue;
-                if (!tile_fits(board, frontier_point, point)) continue;
-
-                // For all neighbors, if the neighbors neighbors == my neighbors -> valid move.
-                auto neighbor_points = point.get_points_around();
-                for (Position &neighbor_point : neighbor_points) {
-                    if (board[neighbor_point] != EMPTY) continue;
-                    for (Position &double_neighbor : points) {
-                        if (neighbor_point != double_neighbor) continue;
+    board[orig] = tile_type;
 
-                        if (!tile_fits(board, frontier_point, double_neighbor)) continue;
+    for (int i = 0; i < n_reachable; i++) {
+        add_child<false>(reachable[i], tile_type, orig);
+    }
+}
 
-                        // Skip tile if we already added this point.
-                        if (spider_visited[neighbor_point.y][neighbor_point.x]) continue;
-                        spider_visited[neighbor_point.y][neighbor_point.x] = true;
+/*
+ * Generates the moves of all tiles of one type and colour, which are resolved at compile time.
+ */
+template <typename T>
+template <int Type, int Color>
+void BaseNode<T>::generate_piece_moves() {
+    constexpr int first = tile_type_offset(Type | Color);
+    constexpr int count = tile_type_count(Type);
 
-                        next_frontier.push_back(neighbor_point);
-                    }
-                }
-            }
+#pragma unroll
+    for (int i = 0; i < count; i++) {
+        Position position = board.tile_positions[first + i];
+        if (position.x == -1) continue;
+
+        // Tiles covered by a beetle cannot move.
+        constexpr uint8_t base_tile = Type | Color;
+        if (board[position] != (base_tile | ((i + 1) << NUMBER_SHIFT))) continue;
+
+        if (!board.free[position.flat_index()]) continue;
+
+        // If this tile can be removed without breaking the hive, add it to the valid moves list.
+        if constexpr (Type == L_GRASSHOPPER) {
+            generate_grasshopper_moves(position);
+        } else if constexpr (Type == L_BEETLE) {
+            generate_beetle_moves(position);
+        } else if constexpr (Type == L_ANT) {
+            generate_ant_moves(position);
+        } else if constexpr (Type == L_QUEEN) {
+            generate_queen_moves(position);
+        } else if constexpr (Type == L_SPIDER) {
+            generate_spider_moves(position);
         }
-        // Swap two frontiers.
-        frontier.swap(next_frontier);
-        next_frontier.clear();
-    }
-    board[orig] = tile_type;
-
-    for (Position &point : frontier) {
-        add_child<false>(point, tile_type, orig);
     }
 }
 
 template <typename T>
-void BaseNode<T>::generate_free_moves(int player_bit) {
-
+template <int Color>
+void BaseNode<T>::generate_free_moves(int flags) {
     // We do a full update as soon as we want to move.
     board.update_can_move(move.location, move.previous_location);
 
-#ifdef CENTERED
-    int ly = board->min_y, hy = board->max_y + 1;
-    int lx = board->min_x, hx = board->max_x + 1;
-#else
-    int8_t ly = 0, hy = BOARD_SIZE;
-    int8_t lx = 0, hx = BOARD_SIZE;
-#endif
-
-    Position position;
-    for (int8_t y = ly; y < hy; y++) {
-        for (int8_t x = lx; x < hx; x++) {
-            position.x = x;
-            position.y = y;
-
-            unsigned char tile = board[position];
-            if (tile == EMPTY) continue;
-            // Only move your own tiles
-            if ((tile & COLOR_MASK) != player_bit) continue;
-
-            if (!board.free[position.y][position.x]) continue;
-
-            // If this tile can be removed without breaking the hive, add it to the valid moves list.
-            if ((tile & TILE_MASK) == L_GRASSHOPPER) {
-                generate_grasshopper_moves( position);
-            } else if ((tile & TILE_MASK) == L_BEETLE) {
-                generate_beetle_moves( position);
-            } else if ((tile & TILE_MASK) == L_ANT) {
-                generate_ant_moves( position);
-            } else if ((tile & TILE_MASK) == L_QUEEN) {
-                generate_queen_moves( position);
-            } else if ((tile & TILE_MASK) == L_SPIDER) {
-                generate_spider_moves( position);
-            }
-        }
+    if ((flags & MOVE_ONLY_ANTS_SPIDERS) == 0) {
+        generate_piece_moves<L_GRASSHOPPER, Color>();
+        generate_piece_moves<L_BEETLE, Color>();
+    }
+    if ((flags & MOVE_NO_ANTS) == 0)
+        generate_piece_moves<L_ANT, Color>();
+    if ((flags & MOVE_ONLY_ANTS_SPIDERS) == 0)
+        generate_piece_moves<L_QUEEN, Color>();
+    if ((flags & MOVE_NO_SPIDERS) == 0)
+        generate_piece_moves<L_SPIDER, Color>();
+}
+
+template <typename T>
+void BaseNode<T>::generate_moves(int flags) {
+    if (board.turn % 2 == 0) {
+        generate_moves<LIGHT>(flags);
+    } else {
+        generate_moves<DARK>(flags);
     }
 }
 
 template <typename T>
-void BaseNode<T>::generate_moves() {
-    int player_idx = board.turn % 2;
-    int player_bit = player_idx << COLOR_SHIFT;
+template <int Color>
+void BaseNode<T>::generate_moves(int flags) {
+    constexpr int player_idx = Color >> COLOR_SHIFT;
 
     int player_move = board.turn / 2;
 
     Board::player_info &player = board.players[player_idx];
     // By player_move 4 for each player, the queen has to be placed.
     if (player_move == 3 && player.queens_left == 1) {
-        return generate_placing_moves(L_QUEEN | player_bit);
+        if ((flags & MOVE_ONLY_ANTS_SPIDERS) == 0)
+            generate_placing_moves<Color>(L_QUEEN | Color);
+        return;
+    }
+
+    // Tiles can only be moved if their queen is on the board.
+    if (flags & MOVE_ONLY_ANTS_SPIDERS) {
+        if (player.queens_left == 0)
+            generate_free_moves<Color>(flags);
+        return;
     }
 
     if (player.spiders_left > 0) {
-        generate_placing_moves(L_SPIDER | player_bit);
+        generate_placing_moves<Color>(L_SPIDER | Color);
     }
     if (player.beetles_left > 0) {
-        generate_placing_moves(L_BEETLE | player_bit);
+        generate_placing_moves<Color>(L_BEETLE | Color);
     }
     if (player.grasshoppers_left > 0) {
-        generate_placing_moves( L_GRASSHOPPER | player_bit);
+        generate_placing_moves<Color>(L_GRASSHOPPER | Color);
     }
     if (player.ants_left > 0) {
-        generate_placing_moves(L_ANT | player_bit);
+        generate_placing_moves<Color>(L_ANT | Color);
     }
 
     // Queens cannot be placed in the first player_move (tournament rules)
     if (player.queens_left > 0 && player_move > 0)
-        generate_placing_moves(L_QUEEN | player_bit);
+        generate_placing_moves<Color>(L_QUEEN | Color);
 
     // Tiles can only be moved if their queen is on the board.
     if (player.queens_left == 0)
-        generate_free_moves(player_bit);
+        generate_free_moves<Color>(flags);
 }
 
 
@@ -452,17 +382,21 @@ void BaseNode<T>::print() {
     std::cout << board.to_string() << std::endl;
 }
 
+/*
+ * Returns 0 if nothing went wrong, an error-code otherwise.
+ * With one of the MOVE_PARTIAL flags only part of the moves is generated, and 1 is returned if that part is empty.
+ */
 template <typename T>
-int BaseNode<T>::generate_children() {
+int BaseNode<T>::generate_children(int flags) {
     if (board.turn >= MAX_TURNS - 1) {
         return ERR_NOMOVES;
     }
 
     // Only generate more nodes if you have no nodes yet
     if (children.empty()) {
-        generate_moves();
+        generate_moves(flags);
 
-        if (children.empty()) {
+        if (children.empty() && (flags & MOVE_PARTIAL) == 0) {
             // Generate dummy move (pass)
             Position dummy_pos = Position(-1, -1);
             add_child<false>(dummy_pos, 0, dummy_pos);
@@ -485,6 +419,8 @@ void BaseNode<T>::add_child(const Position &location, int type, const Position &
     BaseNode<T> child = copy();
 
     child.parent = this;
+    // Heights of the tile in its stack before and after the move, for the hash.
+    int height = 0, old_height = 0;
 
     if (location.x == -1) {
         // No valid moves are available
@@ -525,7 +461,9 @@ void BaseNode<T>::add_child(const Position &location, int type, const Position &
     } else {
         Board::tile_stack *ts = child.board.get_from_stack(previous_location, true);
         child.board.tiles[previous_location.y][previous_location.x] = (ts == nullptr ? EMPTY : ts->type);
+        if (ts != nullptr) old_height = ts->z + 1;
     }
+    child.board.tile_positions[tile_position_index(type)] = location;
 
     // If this move is on top of an existing tile, store this tile in the stack
     if (child.board.tiles[location.y][location.x] != EMPTY) {
@@ -538,6 +476,7 @@ void BaseNode<T>::add_child(const Position &location, int type, const Position &
                 tile_stack.position = location;
                 tile_stack.type = child.board.tiles[location.y][location.x];
                 tile_stack.z = (ts == nullptr ? 0 : ts->z + 1);
+                height = tile_stack.z + 1;
                 break;
             }
         }
@@ -554,7 +493,7 @@ void BaseNode<T>::add_child(const Position &location, int type, const Position &
     }
 
     // Update the zobrist hash for this child
-    zobrist_hash(child.board, location, previous_location, type);
+    zobrist_hash(child.board, location, previous_location, type, height, old_height);
 
     // Store hash history
 //    board.hash_history.push_back(board.zobrist_hash);
@@ -582,6 +521,7 @@ void BaseNode<T>::add_child(const Position &location, int type, const Position &
         // After this move, ensure this board is centered.
         child.board.center();
     }
+    zobrist_rebase(child.board);
 
     child.move.previous_location = previous_location;
     child.move.location = location;
@@ -33,7 +33,7 @@ public:
 
     void print();
 
-    int generate_children();
+    int generate_children(int flags = 0);
 
     void generate_directional_grasshopper_moves(Position &orig_pos, int x_incr, int y_incr);
 
@@ -47,8 +47,13 @@ public:
 
     void generate_spider_moves(Position &orig);
 
-    void generate_free_moves(int player_bit);
+    template<int Type, int Color>
+    void generate_piece_moves();
 
+    template<int Color>
+    void generate_free_moves(int flags);
+
+    template<int Color>
     void generate_placing_moves(uint8_t type);
 
 
@@ -57,7 +62,10 @@ public:
 
     [[nodiscard]] std::string get_move() const;
 
-    void generate_moves();
+    void generate_moves(int flags = 0);
+
+    template<int Color>
+    void generate_moves(int flags);
 };
 
 #pragma pack(pop)
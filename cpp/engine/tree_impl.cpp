@@ -11,7 +11,16 @@ public:
     int visitCount = 0;
 };
 
+class NNData {
+public:
+    float value = 0.0f;
+    int visitCount = 0;
+    // Probability of the move leading to this node according to the policy of the network.
+    float prior = 0.0f;
+};
+
 template class BaseNode<MCTSData>;
+template class BaseNode<NNData>;
 template class BaseNode<DefaultData>;
 
 #endif //BEEKEEPER_HIVE_IMPL
\ No newline at end of file
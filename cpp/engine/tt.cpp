@@ -10,23 +10,101 @@
 struct tt_entry *tt_table = nullptr;
 int64_t *zobrist_table = nullptr;
 
+/*
+ * The hash of a board sums a key per tile type times X^x * Y^y over the tiles, modulo 2^64, in zobrist_sum.
+ * Moving the whole hive by (dx, dy) multiplies the sum by X^dx * Y^dy, so center() updates it in O(1), and dividing
+ *  out the lowest x and y of the hive gives the same zobrist_hash wherever the hive lies. The same as the C engine.
+ * X and Y are odd so they have an inverse; zobrist_origin holds the inverse of zobrist_location.
+ * The key of a tile is also multiplied by a factor for its height in the stack, so the order of a stack matters.
+ */
+static uint64_t zobrist_location[BOARD_SIZE * BOARD_SIZE];
+static uint64_t zobrist_origin[BOARD_SIZE * BOARD_SIZE];
+static uint64_t zobrist_height[TILE_STACK_SIZE + 1];
+
+static uint64_t random_64() {
+    int32_t r1 = rand(), r2 = rand();
+    return uint64_t(r1) + (uint64_t(r2) << 32);
+}
+
+/*
+ * Inverse of an odd number modulo 2^64 by Newton's iteration, every step doubles the correct bits.
+ */
+static uint64_t inverse_64(uint64_t a) {
+    uint64_t inverse = a;
+    for (int i = 0; i < 5; i++) {
+        inverse *= 2 - a * inverse;
+    }
+    return inverse;
+}
+
+/*
+ * The low bits of the sum only depend on the keys, not on the locations, so it is mixed before it is used as a hash.
+ */
+static int64_t zobrist_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return int64_t(h);
+}
 
 void zobrist_init() {
-    zobrist_table = static_cast<int64_t *>(malloc(BOARD_SIZE * BOARD_SIZE * N_UNIQUE_TILES * 2 * sizeof(int64_t)));
-    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE * N_UNIQUE_TILES * 2; i++) {
-        int32_t r1 = rand(), r2 = rand();
-        zobrist_table[i] = r1 + ((int64_t) r2 << 32);
+    zobrist_table = static_cast<int64_t *>(malloc(N_UNIQUE_TILES * 2 * sizeof(int64_t)));
+    for (int i = 0; i < N_UNIQUE_TILES * 2; i++) {
+        zobrist_table[i] = int64_t(random_64());
+    }
+
+    uint64_t x_factor = random_64() | 1, y_factor = random_64() | 1;
+    uint64_t x_inverse = inverse_64(x_factor), y_inverse = inverse_64(y_factor);
+    uint64_t row = 1, row_inverse = 1;
+    for (int y = 0; y < BOARD_SIZE; y++) {
+        uint64_t factor = row, inverse = row_inverse;
+        for (int x = 0; x < BOARD_SIZE; x++) {
+            zobrist_location[y * BOARD_SIZE + x] = factor;
+            zobrist_origin[y * BOARD_SIZE + x] = inverse;
+            factor *= x_factor;
+            inverse *= x_inverse;
+        }
+        row *= y_factor;
+        row_inverse *= y_inverse;
+    }
+
+    // Tiles on the ground keep their plain key.
+    zobrist_height[0] = 1;
+    for (int z = 1; z <= TILE_STACK_SIZE; z++) {
+        zobrist_height[z] = random_64() | 1;
     }
 }
 
-void zobrist_hash(Board &board, const Position &location, const Position &old_location, int type) {
-    int tile_type = type & TILE_MASK;
+/*
+ * Moves a tile of the given type in the sum of the board, from old_location at old_height to location at height.
+ * A location with x -1 is off the board. The hash itself is updated by zobrist_rebase, once the bounds of the hive
+ *  are known.
+ */
+void zobrist_hash(Board &board, const Position &location, const Position &old_location, int type, int height,
+                  int old_height) {
+    int tile_type = (type & TILE_MASK) - 1;
     int color = (type & COLOR_MASK) >> COLOR_SHIFT;
-    int idx = tile_type + N_UNIQUE_TILES * color;
+    auto key = uint64_t(zobrist_table[tile_type + N_UNIQUE_TILES * color]);
     if (location.x >= 0)
-        board.zobrist_hash ^= zobrist_table[location.flat_index() * N_UNIQUE_TILES * 2 + idx];
+        board.zobrist_sum += key * zobrist_height[height] * zobrist_location[location.flat_index()];
     if (old_location.x >= 0)
-        board.zobrist_hash ^= zobrist_table[old_location.flat_index() * N_UNIQUE_TILES * 2 + idx];
+        board.zobrist_sum -= key * zobrist_height[old_height] * zobrist_location[old_location.flat_index()];
+}
+
+/*
+ * Updates the sum for a translation of the board that moves the tile at from to to.
+ */
+void zobrist_translate(Board &board, const Position &from, const Position &to) {
+    board.zobrist_sum *= zobrist_location[to.flat_index()] * zobrist_origin[from.flat_index()];
+}
+
+/*
+ * Sets the hash of the board from its sum, relative to the lowest x and y of the hive.
+ */
+void zobrist_rebase(Board &board) {
+    board.zobrist_hash = zobrist_mix(board.zobrist_sum * zobrist_origin[board.min.flat_index()]);
 }
 
 //void tt_store(BaseNode &node, float score, char flag, int depth, int player) {
@@ -26,7 +26,12 @@ extern int64_t *zobrist_table;
 
 void zobrist_init();
 
-void zobrist_hash(Board &board, const Position &location, const Position &old_location, int type);
+void zobrist_hash(Board &board, const Position &location, const Position &old_location, int type, int height,
+                  int old_height);
+
+void zobrist_translate(Board &board, const Position &from, const Position &to);
+
+void zobrist_rebase(Board &board);
 
 
 //#define TT_TABLE_SIZE (1024*1024*256)
@@ -4,25 +4,11 @@
 #include "utils.h"
 
 int to_tile_index(unsigned char tile) {
-    int type = tile & TILE_MASK;
-    if (type == EMPTY) {
+    if ((tile & TILE_MASK) == EMPTY) {
         return 0;
     }
-
-    int color = (tile & COLOR_MASK) >> COLOR_SHIFT;
-    int sum = color * N_TILES + 1; // +1, 0 is empty tile.
-    int n = ((tile & NUMBER_MASK) >> NUMBER_SHIFT) - 1;
-
-    if (type == L_ANT) return sum + n;
-    sum += N_ANTS;
-    if (type == L_GRASSHOPPER) return sum + n;
-    sum += N_GRASSHOPPERS;
-    if (type == L_BEETLE) return sum + n;
-    sum += N_BEETLES;
-    if (type == L_SPIDER) return sum + n;
-    sum += N_SPIDERS;
-    // It must be a queen.
-    return sum + n;
+    // +1, 0 is empty tile.
+    return tile_position_index(tile) + 1;
 }
 
 unsigned long mix(unsigned long a, unsigned long b, unsigned long c) {
@@ -56,47 +42,52 @@ unsigned long mix(unsigned long a, unsigned long b, unsigned long c) {
     return c;
 }
 
-bool has_neighbour(Board &board, Position &location) {
-    auto points = location.get_points_around();
-    for (Position &point : points) {
-        if (board.tiles[point.y][point.x] != EMPTY) {
-            return true;
+/*
+ * Finds the positions a tile at origin can walk to, the tile itself has to be removed from the board beforehand.
+ * If steps is -1, the tile is an ant and walks any distance along the hive, all reachable positions are stored.
+ * Otherwise, only the positions reached after exactly that many crawling steps are stored.
+ * Returns the amount of positions stored in reachable.
+ */
+int find_reachable(Board &board, const Position &origin, int steps, Position *reachable) {
+    uint64_t visited[(BOARD_SIZE * BOARD_SIZE + 63) / 64] = {0};
+    // Every position enters the queue once, together with its neighbour mask.
+    std::pair<Position, int> queue[REACHABLE_QUEUE_SIZE];
+    unsigned int head = 0, tail = 0;
+    int n_reachable = 0;
+    bool ant = steps == -1;
+
+    if (ant) visited[origin.flat_index() / 64] |= 1ull << (origin.flat_index() % 64);
+    queue[tail++ & (REACHABLE_QUEUE_SIZE - 1)] = {origin, neighbour_mask(board, origin)};
+
+    for (int step = 0; head != tail and (ant or step < steps); step++) {
+        unsigned int layer_end = tail;
+        while (head != layer_end) {
+            auto [position, mask] = queue[head++ & (REACHABLE_QUEUE_SIZE - 1)];
+            int directions = ant ? slide_directions[mask] & ~mask : crawl_directions[mask];
+
+            auto points = position.get_points_around();
+            for (int d = 0; d < 6; d++) {
+                if ((directions & (1 << d)) == 0) continue;
+
+                const Position &point = points[d];
+                int index = point.flat_index();
+                if (visited[index / 64] & (1ull << (index % 64))) continue;
+
+                int point_mask = neighbour_mask(board, point);
+                // Ants still have to stay connected to the hive.
+                if (point_mask == 0) continue;
+
+                visited[index / 64] |= 1ull << (index % 64);
+                queue[tail++ & (REACHABLE_QUEUE_SIZE - 1)] = {point, point_mask};
+                if (ant) reachable[n_reachable++] = point;
+            }
         }
     }
-    return false;
-}
+    if (ant) return n_reachable;
 
-bool tile_fits(Board &board, Position &point, Position &new_point) {
-    bool tl = board.tiles[point.y - 1][point.x - 1] == EMPTY;
-    bool tr = board.tiles[point.y - 1][point.x + 0] == EMPTY;
-    bool l = board.tiles[point.y + 0][point.x - 1] == EMPTY;
-    bool r = board.tiles[point.y + 0][point.x + 1] == EMPTY;
-    bool bl = board.tiles[point.y + 1][point.x + 0] == EMPTY;
-    bool br = board.tiles[point.y + 1][point.x + 1] == EMPTY;
-
-    int xd = point.x - new_point.x;
-    int yd = point.y - new_point.y;
-    if (xd == -1 && yd == 0) {
-        // Going to the right
-        return tr || br;
-    } else if (xd == 1 && yd == 0) {
-        // Going to the left
-        return tl || bl;
-    } else if (xd == 1 && yd == 1) {
-        // Going to the top left
-        return l || tr;
-    } else if (xd == 0 && yd == 1) {
-        // Going to the top right
-        return r || tl;
-    } else if (xd == 0 && yd == -1) {
-        // Going to the bottom left
-        return l || br;
-    } else if (xd == -1 && yd == -1) {
-        // Going to the bottom right
-        return r || bl;
+    // The last layer of the queue holds the positions reached after all steps.
+    while (head != tail) {
+        reachable[n_reachable++] = queue[head++ & (REACHABLE_QUEUE_SIZE - 1)].first;
     }
-    std::   cout << board.to_string() << std::endl;
-    std::cerr << "Invalid neighbour found, check the coordinates. " << point.to_string() << " -> "
-              << new_point.to_string() << std::endl;
-    throw std::invalid_argument("Invalid coords.");
-}
\ No newline at end of file
+    return n_reachable;
+}
@@ -4,16 +4,81 @@
 
 
 // Do includes after defines.
+#include <array>
 #include "position.h"
 #include "board.h"
 
+#define SPIDER_STEPS 3
+// Power of two which is larger than the amount of empty locations around a full hive.
+#define REACHABLE_QUEUE_SIZE 256
+
+/*
+ * The two points shared by a position and its neighbour in direction p (in the order of get_points_around),
+ *  a tile moving in direction p has to slide through the gap between these.
+ */
+constexpr int slide_gates[6][2] = {{2, 1}, {3, 0}, {0, 4}, {1, 5}, {2, 5}, {3, 4}};
+
+/*
+ * Indexed by the occupancy mask of the 6 points around a position.
+ * Crawling requires an empty destination, and a tile in the gap to walk along.
+ */
+constexpr std::array<uint8_t, 64> make_slide_directions(bool crawl) {
+    std::array<uint8_t, 64> directions{};
+    for (int mask = 0; mask < 64; mask++) {
+        for (int d = 0; d < 6; d++) {
+            int gate = (1 << slide_gates[d][0]) | (1 << slide_gates[d][1]);
+            if ((mask & gate) == gate) continue;
+            if (crawl and ((mask & gate) == 0 or (mask & (1 << d)) != 0)) continue;
+
+            directions[mask] |= 1 << d;
+        }
+    }
+    return directions;
+}
+
+constexpr std::array<uint8_t, 64> slide_directions = make_slide_directions(false);
+constexpr std::array<uint8_t, 64> crawl_directions = make_slide_directions(true);
+
+/*
+ * Returns the occupancy mask of the points around a position, bit p is set if the p-th point is not empty.
+ */
+inline int neighbour_mask(Board &board, const Position &position) {
+    int mask = 0;
+    int p = 0;
+    for (const Position &point : position.get_points_around()) {
+        mask |= (board.tiles[point.y][point.x] != EMPTY) << p++;
+    }
+    return mask;
+}
+
 int to_tile_index(unsigned char tile);
 
 // http://www.concentric.net/~Ttwang/tech/inthash.htm
 unsigned long mix(unsigned long a, unsigned long b, unsigned long c);
 
-bool tile_fits(Board &board, Position &point, Position &new_point);
+/*
+ * Returns the index of the neighbour at the given offset in the order of get_points_around, or -1 if it is no neighbour.
+ */
+constexpr int neighbour_direction(int dx, int dy) {
+    constexpr int directions[3][3] = {{0, 1, -1},
+                                      {2, -1, 3},
+                                      {-1, 4, 5}};
+    if (dx < -1 or dx > 1 or dy < -1 or dy > 1) return -1;
+    return directions[dy + 1][dx + 1];
+}
+
+/*
+ * Whether a tile can slide from point to the neighbouring new_point without squeezing between two tiles.
+ */
+inline bool tile_fits(Board &board, const Position &point, const Position &new_point) {
+    int direction = neighbour_direction(new_point.x - point.x, new_point.y - point.y);
+    return direction != -1 and (slide_directions[neighbour_mask(board, point)] & (1 << direction)) != 0;
+}
+
+inline bool has_neighbour(Board &board, const Position &location) {
+    return neighbour_mask(board, location) != 0;
+}
 
-bool has_neighbour(Board &board, Position &location);
+int find_reachable(Board &board, const Position &origin, int steps, Position *reachable);
 
 #endif //BEEKEEPER_UTILS_H
@@ -20,7 +20,7 @@ void run_random() {
 void run_mcts() {
     Game game = Game<BaseNode<MCTSData>>();
 
-    ai_mcts::run_mcts(game.root);
+    ai_mcts::run_mcts(game.root, game.rng);
 
     for (BaseNode<MCTSData>& child : game.root.children) {
         std::cout << " has value " << child.data.value / child.data.visitCount << " with visit count " << child.data.visitCount << std::endl;
@@ -13,7 +13,7 @@ int node_encode_absolute(BaseNode<MCTSData> &node) {
 }
 
 
-int ai_mcts::naive_playout(BaseNode<MCTSData> *root) {
+int ai_mcts::naive_playout(BaseNode<MCTSData> *root, Random &rng) {
     BaseNode<MCTSData> node = *root;
 
     int depth = 0;
@@ -29,7 +29,7 @@ int ai_mcts::naive_playout(BaseNode<MCTSData> *root) {
             throw std::runtime_error("No moves can be generated, but no final state was determined.");
         }
 
-        int random_child = rand() % int(node.children.size());
+        int random_child = int(rng.below(node.children.size()));
         int i = 0;
         for (const BaseNode<MCTSData> &child : node.children) {
             if (i == random_child) {
@@ -132,14 +132,14 @@ void ai_mcts::cascade_result(BaseNode<MCTSData> *leaf, float value) {
     }
 }
 
-void ai_mcts::run_mcts(BaseNode<MCTSData> &root) {
+void ai_mcts::run_mcts(BaseNode<MCTSData> &root, Random &rng) {
     int n_iters = 1000;
 
     root.generate_children();
 
     for (int i = 0; i < n_iters; i++) {
         BaseNode<MCTSData> &leaf = select_leaf(&root);
-        int game_value = naive_playout(&leaf);
+        int game_value = naive_playout(&leaf, rng);
 
         float value;
         if (game_value == LIGHT_WON) {
@@ -3,6 +3,7 @@
 #define BEEKEEPER_AI_MCTS_H
 
 #include <torch/extension.h>
+#include <random.h>
 #include <tree_impl.cpp>
 
 
@@ -11,13 +12,13 @@ public:
 
 //    static torch::Tensor evaluate(torch::jit::script::Module &model);
 
-    static int naive_playout(BaseNode<MCTSData> *root);
+    static int naive_playout(BaseNode<MCTSData> *root, Random &rng);
 
     [[nodiscard]] static BaseNode<MCTSData>& select_leaf(BaseNode<MCTSData> *root);
 
     static void cascade_result(BaseNode<MCTSData> *leaf, float value);
 
-    static void run_mcts(BaseNode<MCTSData> &root);
+    static void run_mcts(BaseNode<MCTSData> &root, Random &rng);
 
     static void run_ai_mcts(BaseNode<MCTSData> &root, torch::jit::script::Module &model);
 
@@ -0,0 +1,245 @@
+
+#include <game.h>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include "self_play.h"
+
+
+self_play::self_play(Evaluator player, Evaluator opponent, const self_play_config &config)
+        : player(std::move(player)), opponent(std::move(opponent)), config(config), rng(config.seed),
+          policy(POLICY_SIZE) {}
+
+/*
+ * Value of a finished board for the player to move in it.
+ */
+static float terminal_value(Board &board, int result) {
+    if (result == DRAW) return 0.f;
+
+    bool light_to_move = board.turn % 2 == 0;
+    return (result == LIGHT_WON) == light_to_move ? 1.f : -1.f;
+}
+
+/*
+ * Sets up the board with the hive where unpacking its packed position puts it, which is where the networks see it
+ *  and where the records store it. Returns the offset of the locations of the centered board from the board.
+ */
+static Position center_packed(Board &board, Board &centered) {
+    packed_position packed;
+    board.pack(packed);
+    centered.unpack(packed);
+
+    for (int i = 0; i < N_TILES * 2; i++) {
+        if (board.tile_positions[i].x == -1) continue;
+        return Position(centered.tile_positions[i].x - board.tile_positions[i].x,
+                        centered.tile_positions[i].y - board.tile_positions[i].y);
+    }
+    return Position(0, 0);
+}
+
+static int centered_encoding(const Move &move, const Position &offset) {
+    Move centered = move;
+    centered.location = Position(move.location.x + offset.x, move.location.y + offset.y);
+    return centered.encode(ENCODING_ABSOLUTE);
+}
+
+/*
+ * Generates the children of the leaf, and sets their priors from the policy of the network normalized over the
+ *  valid moves. Returns the value of the leaf for the player to move in it.
+ */
+float self_play::expand(NNNode &leaf, Evaluator &evaluate) {
+    Board centered;
+    Position offset = center_packed(leaf.board, centered);
+    float value = evaluate(centered, policy.data());
+    if (leaf.generate_children() != 0) return value;
+
+    float sum = 0.f;
+    for (NNNode &child : leaf.children) {
+        int encoding = centered_encoding(child.move, offset);
+        child.data.prior = encoding == -1 ? 1.f : policy[encoding];
+        sum += child.data.prior;
+    }
+    // A policy without any valid move falls back to uniform priors.
+    for (NNNode &child : leaf.children) {
+        child.data.prior = sum > 0.f ? child.data.prior / sum : 1.f / float(leaf.children.size());
+    }
+    return value;
+}
+
+/*
+ * Descends with PUCT, the value of a node is stored for the player to move in it, so its parent negates it.
+ * The positions on the way are pushed on the history.
+ */
+NNNode &self_play::select_leaf(NNNode &root, hash_history &history) {
+    NNNode *parent = &root;
+    while (!parent->children.empty()) {
+        double sqrt_visits = sqrt(double(parent->data.visitCount));
+
+        NNNode *best = nullptr;
+        double best_value = -INFINITY;
+        for (NNNode &child : parent->children) {
+            double value = child.data.prior * config.exploration_factor * sqrt_visits / (child.data.visitCount + 1);
+            if (child.data.visitCount > 0) value -= child.data.value / child.data.visitCount;
+
+            if (best_value < value) {
+                best_value = value;
+                best = &child;
+            }
+        }
+        parent = best;
+        history.push(parent->board);
+    }
+    return *parent;
+}
+
+void self_play::backpropagate(NNNode *leaf, float value) {
+    int player = leaf->board.turn % 2;
+    for (NNNode *node = leaf; node != nullptr; node = node->parent) {
+        node->data.value += node->board.turn % 2 == player ? value : -value;
+        node->data.visitCount++;
+    }
+}
+
+/*
+ * Runs the iterations of the search from the root, the history holds the positions of the game up to the root.
+ * A leaf which repeats a position of the game or the path is a draw.
+ */
+void self_play::search(NNNode &root, Evaluator &evaluate, hash_history &history) {
+    root.children.clear();
+    root.data = NNData();
+    backpropagate(&root, expand(root, evaluate));
+
+    for (int i = 0; i < config.mcts_iterations; i++) {
+        NNNode &leaf = select_leaf(root, history);
+
+        int result = leaf.board.finished();
+        float value;
+        if (result != UNDECIDED) value = terminal_value(leaf.board, result);
+        else if (history.repetitions() > 0) value = 0.f;
+        else value = expand(leaf, evaluate);
+        backpropagate(&leaf, value);
+
+        history.n = root.board.turn + 1;
+    }
+}
+
+/*
+ * Follows the temperature schedule of the Python simulator; early in the game a move is sampled by its visits,
+ *  after the temperature threshold the most visited move is played.
+ */
+NNNode &self_play::select_move(NNNode &root) {
+    double temperature = double(root.board.turn) / double(MAX_TURNS - 1);
+
+    if (temperature > config.temperature_threshold) {
+        NNNode *best = &root.children.front();
+        for (NNNode &child : root.children) {
+            if (child.data.visitCount > best->data.visitCount) best = &child;
+        }
+        return *best;
+    }
+
+    // The first visit of the root is its own expansion.
+    int n_visits = root.data.visitCount - 1;
+    if (n_visits == 0) {
+        auto choice = root.children.begin();
+        std::advance(choice, rng.below(root.children.size()));
+        return *choice;
+    }
+
+    int selection = int(rng.below(n_visits));
+    for (NNNode &child : root.children) {
+        selection -= child.data.visitCount;
+        if (selection < 0) return child;
+    }
+    return root.children.back();
+}
+
+/*
+ * Plays a game, the player plays light in even games and dark in odd games. The positions in which the player
+ *  moved are appended to the records. Returns the result of the game.
+ */
+int self_play::play(int game, std::vector<self_play_record> &records) {
+    int player_colour = game % 2;
+    size_t first_record = records.size();
+
+    Game<NNNode> state;
+    NNNode &root = state.root;
+
+    hash_history history;
+    history.push(root.board);
+
+    int result;
+    while ((result = root.board.finished()) == UNDECIDED) {
+        bool own_move = root.board.turn % 2 == player_colour;
+        search(root, own_move ? player : opponent, history);
+
+        if (own_move) {
+            self_play_record &record = records.emplace_back();
+            Board centered;
+            Position offset = center_packed(root.board, centered);
+            centered.pack(record.position.position);
+
+            // The search policy are the visits of the moves, a pass has no encoding so it has no policy.
+            int n_visits = std::max(root.data.visitCount - 1, 1);
+            for (NNNode &child : root.children) {
+                int encoding = centered_encoding(child.move, offset);
+                if (encoding == -1 || child.data.visitCount == 0) continue;
+                record.policy.push_back({uint16_t(encoding), float(child.data.visitCount) / float(n_visits)});
+            }
+            record.position.n_policy = record.policy.size();
+        }
+
+        NNNode next = select_move(root).copy();
+        next.parent = nullptr;
+        root = next;
+
+        // The same position for the third time.
+        history.push(root.board);
+        if (history.repetitions() >= 2) {
+            result = DRAW;
+            break;
+        }
+    }
+
+    int8_t outcome = 0;
+    if (result != DRAW) outcome = (result == LIGHT_WON) == (player_colour == 0) ? 1 : -1;
+    for (size_t i = first_record; i < records.size(); i++) {
+        records[i].position.outcome = outcome;
+    }
+    return result;
+}
+
+/*
+ * Plays the configured amount of games, and writes the records of the player to the file after every game.
+ */
+void self_play::run(const std::string &path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) throw std::runtime_error("Cannot open " + path + " to write the self-play records.");
+
+    self_play_header header{};
+    memcpy(header.magic, SELF_PLAY_MAGIC, sizeof(header.magic));
+    header.n_planes = N_PLANES;
+    header.board_size = BOARD_SIZE;
+    header.policy_size = POLICY_SIZE;
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    int results[4] = {0};
+    std::vector<self_play_record> records;
+    for (int game = 0; game < config.n_games; game++) {
+        records.clear();
+        results[play(game, records)]++;
+
+        for (self_play_record &record : records) {
+            out.write(reinterpret_cast<const char *>(&record.position), sizeof(record.position));
+            out.write(reinterpret_cast<const char *>(record.policy.data()),
+                      std::streamsize(record.policy.size() * sizeof(self_play_policy)));
+        }
+        out.flush();
+    }
+
+    std::cout << "Played " << config.n_games << " games: " << results[LIGHT_WON] << " light wins, "
+              << results[DARK_WON] << " dark wins, " << results[DRAW] << " draws." << std::endl;
+}
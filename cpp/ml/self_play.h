@@ -0,0 +1,92 @@
+
+
+#ifndef BEEKEEPER_SELF_PLAY_H
+#define BEEKEEPER_SELF_PLAY_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <tree_impl.cpp>
+#include <random.h>
+
+using NNNode = BaseNode<NNData>;
+
+/*
+ * Evaluates a board for the player to move in it, filling the policy over the absolute move encodings
+ *  (POLICY_SIZE entries) and returning the value between -1 (loss) and 1 (win). The hive is centered on the board
+ *  as Board::unpack puts it, so the networks see the same boards as in the records.
+ */
+using Evaluator = std::function<float(Board &board, float *policy)>;
+
+struct self_play_config {
+    int n_games = 100;
+    int mcts_iterations = 100;
+    double exploration_factor = 0.6;
+    // Moves are sampled from the search policy until this fraction of the turn limit, the most visited is played after.
+    double temperature_threshold = 0.3;
+    unsigned int seed = 0;
+};
+
+#pragma pack(push, 1)
+
+struct self_play_header {
+    char magic[8];
+    uint32_t n_planes;
+    uint32_t board_size;
+    uint32_t policy_size;
+};
+
+/*
+ * A position played by the player, with the outcome of the game for it (1 is a win, -1 a loss and 0 a draw).
+ * It is followed by n_policy entries of the search policy.
+ */
+struct self_play_position {
+    packed_position position;
+    int8_t outcome;
+    uint16_t n_policy;
+};
+
+struct self_play_policy {
+    uint16_t encoding;
+    float probability;
+};
+
+#pragma pack(pop)
+
+#define SELF_PLAY_MAGIC "HIVESP3"
+
+struct self_play_record {
+    self_play_position position;
+    // Only the moves searched by MCTS, the rest of the policy is zero.
+    std::vector<self_play_policy> policy;
+};
+
+class self_play {
+public:
+    self_play(Evaluator player, Evaluator opponent, const self_play_config &config);
+
+    int play(int game, std::vector<self_play_record> &records);
+
+    void run(const std::string &path);
+
+private:
+    Evaluator player;
+    Evaluator opponent;
+    self_play_config config;
+    Random rng;
+    std::vector<float> policy;
+
+    float expand(NNNode &leaf, Evaluator &evaluate);
+
+    NNNode &select_leaf(NNNode &root, hash_history &history);
+
+    static void backpropagate(NNNode *leaf, float value);
+
+    void search(NNNode &root, Evaluator &evaluate, hash_history &history);
+
+    NNNode &select_move(NNNode &root);
+};
+
+
+#endif //BEEKEEPER_SELF_PLAY_H
@@ -6,7 +6,6 @@
 #include <omp.h>
 #include "game.h"
 #include <tree_impl.cpp>
-#include <ml/ai_mcts.h>
 
 
 int performance_testing(BaseNode<DefaultData> &tree, int depth) {
@@ -34,12 +33,12 @@ int main(int argc, char **argv) {
 
     printf("Running perft with depth %d on %d threads.\n", max_depth, 1);
 
-    Game game = Game<BaseNode<DefaultData>>();
+    // Fixed seed, so the random moves below are the same in every run.
+    Game game = Game<BaseNode<DefaultData>>(1);
 //    for (size_t i = 0; i < 10; i++) {
 //        generate_children(game.root, 1e100);
 //        game.random_move();
 //    }
-    srand(0);
 
     int last = 0;
     struct timespec start, end;
@@ -167,4 +166,22 @@ Depth    | Time (s)        | Nodes           | Knodes/sec
        7 |          3.9714 |        30273650 | (8158.38)
 
 
- */
\ No newline at end of file
+ */
+
+/*
+ * Sliding rules (tile_fits, has_neighbour, ant/spider/queen/beetle moves) through the 64 entry neighbour
+ *  occupancy tables in utils.h. Depth 7 took 4.83-5.07s before this change on the same machine, the
+ *  difference is small because the first 7 plies are mostly placing moves.
+ *
+Running perft with depth 8 on 1 threads.
+Depth    | Time (s)        | Nodes           | Knodes/sec
+---------|-----------------|-----------------|--------------
+       0 |          0.0000 |               1 | (2890.17)
+       1 |          0.0000 |               4 | (367.40)
+       2 |          0.0000 |              16 | (3181.82)
+       3 |          0.0000 |             240 | (6733.05)
+       4 |          0.0004 |            3600 | (8722.27)
+       5 |          0.0114 |           86040 | (7887.68)
+       6 |          0.2753 |         2036580 | (7724.18)
+       7 |          4.6904 |        30273650 | (6907.82)
+ */
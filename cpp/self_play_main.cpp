@@ -0,0 +1,81 @@
+
+#include <getopt.h>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <torch/script.h>
+#include "ml/self_play.h"
+
+/*
+ * Wraps a TorchScript model of the Python package, taking the planes of a board and returning the policy over the
+ *  absolute move encodings and the value of the board.
+ */
+static Evaluator torchscript_evaluator(const std::string &path) {
+    auto model = std::make_shared<torch::jit::script::Module>(torch::jit::load(path, torch::kCPU));
+    model->eval();
+
+    return [model](Board &board, float *policy) {
+        torch::NoGradGuard no_grad;
+
+        uint8_t planes[N_PLANES * BOARD_SIZE * BOARD_SIZE];
+        board.to_planes(planes, board.turn % 2);
+        torch::Tensor input = torch::from_blob(planes, {1, N_PLANES, BOARD_SIZE, BOARD_SIZE}, torch::kUInt8)
+                .to(torch::kFloat32);
+
+        auto output = model->forward({input}).toTuple();
+        torch::Tensor policy_output = output->elements()[0].toTensor().contiguous();
+        std::memcpy(policy, policy_output.data_ptr<float>(), POLICY_SIZE * sizeof(float));
+        return output->elements()[1].toTensor().item<float>();
+    };
+}
+
+static void print_usage(const char *name) {
+    std::cerr << "Usage: " << name << " -m model.pt [-o opponent.pt] [-n games] [-i iterations] [-c exploration] "
+              << "[-s seed] [-f output]" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::string model_path, opponent_path, output_path = "self_play.data";
+    self_play_config config;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:o:n:i:c:s:f:h")) != -1) {
+        switch (opt) {
+            case 'm':
+                model_path = optarg;
+                break;
+            case 'o':
+                opponent_path = optarg;
+                break;
+            case 'n':
+                config.n_games = std::stoi(optarg);
+                break;
+            case 'i':
+                config.mcts_iterations = std::stoi(optarg);
+                break;
+            case 'c':
+                config.exploration_factor = std::stod(optarg);
+                break;
+            case 's':
+                config.seed = std::stoul(optarg);
+                break;
+            case 'f':
+                output_path = optarg;
+                break;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (model_path.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    // Without an opponent the model plays itself.
+    if (opponent_path.empty()) opponent_path = model_path;
+
+    self_play generator(torchscript_evaluator(model_path), torchscript_evaluator(opponent_path), config);
+    generator.run(output_path);
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "engine/dataset.h"
+
+/*
+ * Reads the records written by self_play_records.cpp through the dataset reader of the C engine, and checks every
+ *  record expands to a board of the player and a policy of the searched moves.
+ */
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s records\n", argv[0]);
+        return 1;
+    }
+
+    struct dataset *dataset = dataset_open(argv[1]);
+    if (dataset == NULL) return 1;
+
+    int n_records = dataset_size(dataset);
+    if (n_records == 0) {
+        fprintf(stderr, "The file has no records.\n");
+        return 1;
+    }
+
+    uchar *planes = malloc(N_PLANES * BOARD_SIZE * BOARD_SIZE);
+    float *policy = malloc(POLICY_SIZE * sizeof(float));
+    int errors = 0, previous_player = 0, n_policies = 0;
+    for (int i = 0; i < n_records; i++) {
+        int outcome = dataset_get(dataset, i, 0, planes, policy);
+        if (outcome < -1 || outcome > 1) {
+            fprintf(stderr, "Record %d has outcome %d.\n", i, outcome);
+            errors++;
+        }
+
+        // The player plays light in the first game and dark in the second, so the player plane only changes once.
+        int player = planes[N_TILES * 2 * BOARD_SIZE * BOARD_SIZE];
+        if (player < previous_player) {
+            fprintf(stderr, "Record %d is of player %d after a record of player %d.\n", i, player, previous_player);
+            errors++;
+        }
+        previous_player = player;
+
+        int n_tiles = 0;
+        for (int j = 0; j < N_TILES * 2 * BOARD_SIZE * BOARD_SIZE; j++) n_tiles += planes[j];
+        if (n_tiles == 0 && i > 0) {
+            fprintf(stderr, "Record %d has an empty board.\n", i);
+            errors++;
+        }
+
+        // The visits of the moves besides a pass out of all visits of the root, so a pass leaves an empty policy.
+        float sum = 0.f;
+        for (int j = 0; j < POLICY_SIZE; j++) sum += policy[j];
+        if (sum < 0.f || sum > 1.001f) {
+            fprintf(stderr, "Record %d has a policy summing to %f.\n", i, sum);
+            errors++;
+        }
+        if (sum > 0.f) n_policies++;
+    }
+    if (n_policies == 0) {
+        fprintf(stderr, "No record has a policy.\n");
+        errors++;
+    }
+    printf("Read %d records, %d errors.\n", n_records, errors);
+
+    free(planes);
+    free(policy);
+    dataset_close(dataset);
+    return errors != 0;
+}
@@ -0,0 +1,29 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include "ml/self_play.h"
+
+/*
+ * Plays a few short self-play games with an evaluator giving every move the same prior and every board a value of 0,
+ *  and writes their records to the file given as the argument, to be read back by read_records.c.
+ */
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " records" << std::endl;
+        return 1;
+    }
+
+    Evaluator uniform = [](Board &board, float *policy) {
+        std::fill(policy, policy + POLICY_SIZE, 1.f / POLICY_SIZE);
+        return 0.f;
+    };
+
+    self_play_config config;
+    config.n_games = 2;
+    config.mcts_iterations = 16;
+    config.seed = 1;
+
+    self_play generator(uniform, uniform, config);
+    generator.run(argv[1]);
+    return 0;
+}
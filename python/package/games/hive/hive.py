@@ -12,7 +12,13 @@ from games.Game import Game, GameNode
 from games.utils import GameState, Perspectives
 
 lib = CDLL(os.path.join(os.path.dirname(os.path.realpath(__file__)), "libhive.so"))
+
+# The C++ engine core (cpp/capi/capi.h), built as libcxx_hive.so and copied next to this file. Nodes are generated by it
+#  instead of by the C engine when Hive.core is "cxx".
+_cxx_path = os.path.join(os.path.dirname(os.path.realpath(__file__)), "libcxx_hive.so")
+cxx_lib = CDLL(_cxx_path) if os.path.exists(_cxx_path) else None
 BOARD_SIZE = c_uint.in_dll(lib, "pboardsize").value
+N_FREE_WORDS = (BOARD_SIZE * BOARD_SIZE + 63) // 64
 TILE_STACK_SIZE = c_uint.in_dll(lib, "ptilestacksize").value
 N_NODES = c_uint.in_dll(lib, "n_nodes")
 
@@ -30,17 +36,28 @@ TILE_SPIDER = 4
 TILE_QUEEN = 5
 
 N_TILES = 22
+N_UNIQUE_TILES = 5
+N_PLANES = c_uint.in_dll(lib, "pnplanes").value
+N_SYMMETRIES = c_uint.in_dll(lib, "pnsymmetries").value
+
+ENCODING_ABSOLUTE = 0
+ENCODING_RELATIVE = 1
+
+# More than the amount of moves in any position, used to size the buffers of generate_children_batch.
+MAX_CHILDREN = 1024
 
 
 class TileStack(Structure):
+    _pack_ = 1
     _fields_ = [
         ('type', c_ubyte),
-        ('location', c_int),
+        ('location', c_short),
         ('z', c_ubyte)
     ]
 
 
 class Player(Structure):
+    _pack_ = 1
     _fields_ = [
         ('beetles_left', c_ubyte),
         ('grasshoppers_left', c_ubyte),
@@ -50,30 +67,48 @@ class Player(Structure):
     ]
 
 
+class EvalState(Structure):
+    _pack_ = 1
+    _fields_ = [
+        ('queen_neighbours', c_ubyte * 2),
+        ('immobile', c_ubyte * N_UNIQUE_TILES * 2),
+        ('n_top', c_ubyte * 2),
+        ('sum_x', c_short * 2),
+        ('sum_y', c_short * 2),
+        ('sum_squares', c_int * 2),
+    ]
+
+
 class Board(Structure):
+    _pack_ = 1
     _fields_ = [
         ('tiles', c_ubyte * BOARD_SIZE * BOARD_SIZE),
-        ('free', c_bool * BOARD_SIZE * BOARD_SIZE),
+        ('free', c_uint64 * N_FREE_WORDS),
         ('turn', c_int),
         ('players', Player * 2),
 
-        ('light_queen_position', c_int),
-        ('dark_queen_position', c_int),
+        ('light_queen_position', c_short),
+        ('dark_queen_position', c_short),
 
-        ('min_x', c_int),
-        ('min_y', c_int),
-        ('max_x', c_int),
-        ('max_y', c_int),
+        ('min_x', c_byte),
+        ('min_y', c_byte),
+        ('max_x', c_byte),
+        ('max_y', c_byte),
 
         ('n_stacked', c_byte),
         ('stack', TileStack * TILE_STACK_SIZE),
 
-        ('move_location_tracker', c_int),
+        ('n_children', c_short),
 
         ('zobrist_hash', c_longlong),
-        ('hash_history', c_longlong * 180),
+        ('zobrist_sum', c_ulonglong),
 
         ('has_updated', c_bool),
+
+        ('tile_locations', c_short * N_TILES),
+        ('covered', c_uint),
+
+        ('eval', EvalState),
     ]
 
     lookup = [
@@ -92,69 +127,20 @@ class Board(Structure):
 
     def to_np(self, perspective: Perspectives):
         """
-        Convert internal array representation to numpy array
+        Convert internal array representation to numpy array, with a plane per tile and a plane holding the player.
         It will always display the board from white's perspective.
         :return:
         """
         player = 0 if perspective == Perspectives.PLAYER1 else 1
 
-        n_planes = N_TILES + 1
-        height = 1
-        # Fill zero array with raw binary data from library
-        planes = np.zeros((n_planes, height, BOARD_SIZE, BOARD_SIZE), dtype=c_ubyte)
-        board = np.frombuffer(self.tiles, c_ubyte).reshape((26, 26))
-
-        split = N_TILES // 2
-        for i in range(N_TILES):
-            color = (i // split) << COLOR_SHIFT
-            tile = self.lookup[i % split]
-
-            planes[i, 0] = board == (color | tile)
-            # print(board == (color | tile))
-            # print(color | tile)
-
-        planes[-1, 0, :, :] = player
-
-        # print(planes)
-        # print(board)
-        # print(planes.shape)
-        # data_color = (planes[0] & COLOR_MASK) >> COLOR_SHIFT
-        #
-        #
-        # planes[0][data_color == player] = 0
-        # planes[1][data_color != player] = 0
-        #
-        # # Remove number and color from tiles.
-        # planes = (planes & TILE_MASK)
-
-        return planes.reshape((n_planes, BOARD_SIZE, BOARD_SIZE))
-
-        # Compute highest tile in each stack
-        m = defaultdict(int)
-        for tile in self.stack:
-            z, location, tile_type = tile.z, tile.location, tile.type
-            if location == -1:
-                continue
-            m[location] = max(m[location], z)
-
-        # Move current tiles to the point above the highest in the stack
-        for location, height in m.items():
-            x, y = location % 26, location // 26
-            data[height + 1, x, y] = data[0, x, y]
-
-        # Fill the rest of the stacks with the correct tiles
-        for tile in self.stack:
-            z, location, tile_type = tile.z, tile.location, tile.type
-            if location == -1:
-                continue
-            x, y = location % 26, location // 26
-            data[z, x, y] = tile_type
-
-        return data
+        planes = np.empty((N_PLANES, BOARD_SIZE, BOARD_SIZE), dtype=np.uint8)
+        lib.board_planes(byref(self), player, planes.ctypes.data_as(c_void_p))
+        return planes
 
 
+# The list, move and node structs are packed in the library.
 class List(Structure):
-    pass
+    _pack_ = 1
 
 
 List._fields_ = [
@@ -180,6 +166,7 @@ class MCTSData(Structure):
 
 
 class Move(Structure):
+    _pack_ = 1
     _fields_ = [
         ('tile', c_ubyte),
         ('next_to', c_ubyte),
@@ -204,10 +191,21 @@ class Move(Structure):
 # Evaluation function is a switch case for Minimax, it can be 0 or 1;
 #   0 - Queen surrounding prioritization
 #   1 - Opponent tile blocking prioritization
+# MCTS solver propagates proven wins and losses through the MCTS tree, and skips proven nodes during selection.
+# Solver depth is the amount of plies from the root within which a df-pn search looks for a win at new MCTS leaves
+#   near a surrounded queen, 0 disables it.
+# PVS searches all but the first move of Minimax with a null window, and searches again only if that fails high.
+# Aspiration searches every Minimax iteration in a small window around the score of the previous iteration first.
+# Playout length cuts MCTS playouts off after that many plies (0 plays on until the turn limit), after which the player
+#   whose queen has fewer neighbours wins, or with playout evaluation the player favoured by the evaluation function.
+# Playout surround ends a playout as soon as one queen has that many more neighbours than the other, 0 disables it.
+# Seed makes the random choices of the searches repeatable, 0 takes the random seed of the process.
+# History points to the positions played in the game, NULL lets a search only detect repetitions below its root.
 #
 
 
 class PlayerArguments(Structure):
+    _pack_ = 1
     _fields_ = [
         ('algorithm', c_int),
         ('mcts_constant', c_double),
@@ -216,6 +214,15 @@ class PlayerArguments(Structure):
         ('first_play_urgency', c_bool),
         ('verbose', c_bool),
         ('evaluation_function', c_int),
+        ('mcts_solver', c_bool),
+        ('solver_depth', c_int),
+        ('pvs', c_bool),
+        ('aspiration', c_bool),
+        ('playout_length', c_int),
+        ('playout_surround', c_int),
+        ('playout_evaluation', c_bool),
+        ('seed', c_ulonglong),
+        ('history', c_void_p),
     ]
 
 
@@ -225,6 +232,7 @@ class PlayerArguments(Structure):
 
 
 class Arguments(Structure):
+    _pack_ = 1
     _fields_ = [
         ('p1', PlayerArguments),
         ('p2', PlayerArguments),
@@ -232,6 +240,7 @@ class Arguments(Structure):
 
 
 class Node(Structure):
+    _pack_ = 1
     _fields_ = [
         ('children', List),
         ('node', List),
@@ -241,6 +250,13 @@ class Node(Structure):
     ]
 
 
+# The 32 byte position both engines pack a board into, with the same layout.
+class PackedPosition(Structure):
+    _fields_ = [
+        ('bits', c_uint64 * 4),
+    ]
+
+
 # Set return types for all functions we're using here.
 lib.game_init.restype = POINTER(Node)
 lib.list_get_node.restype = POINTER(Node)
@@ -256,18 +272,82 @@ lib.mcts.restype = POINTER(Node)
 
 lib.string_move.argtypes = [POINTER(Node)]
 lib.string_move.restype = c_char_p
+lib.generate_children_batch.argtypes = [POINTER(Node), c_double, POINTER(POINTER(Node)), c_void_p, c_void_p, c_int,
+                                        c_void_p, c_int]
+lib.board_planes.argtypes = [POINTER(Board), c_int, c_void_p]
+lib.encode_move.argtypes = [POINTER(Move), c_int]
+lib.dataset_open.argtypes = [c_char_p]
+lib.dataset_open.restype = c_void_p
+lib.dataset_close.argtypes = [c_void_p]
+lib.dataset_size.argtypes = [c_void_p]
+lib.dataset_get.argtypes = [c_void_p, c_int, c_int, c_void_p, c_void_p]
+lib.dataset_outcomes.argtypes = [c_void_p, c_void_p]
+lib.board_pack.argtypes = [POINTER(Board), POINTER(PackedPosition)]
+lib.board_unpack.argtypes = [POINTER(Board), POINTER(PackedPosition)]
+
+# The nodes of the C++ engine are opaque handles.
+if cxx_lib is not None:
+    cxx_lib.game_init.restype = c_void_p
+    cxx_lib.node_from_packed.argtypes = [POINTER(PackedPosition)]
+    cxx_lib.node_from_packed.restype = c_void_p
+    cxx_lib.node_pack.argtypes = [c_void_p, POINTER(PackedPosition)]
+    cxx_lib.node_planes.argtypes = [c_void_p, c_int, c_void_p]
+    cxx_lib.node_turn.argtypes = [c_void_p]
+    cxx_lib.node_get_move.argtypes = [c_void_p, c_void_p]
+    cxx_lib.node_copy.argtypes = [c_void_p]
+    cxx_lib.node_copy.restype = c_void_p
+    cxx_lib.node_take_child.argtypes = [c_void_p, c_void_p]
+    cxx_lib.node_take_child.restype = c_void_p
+    cxx_lib.node_free_children.argtypes = [c_void_p]
+    cxx_lib.node_free.argtypes = [c_void_p]
+    cxx_lib.finished_board.argtypes = [c_void_p]
+    cxx_lib.print_board.argtypes = [c_void_p]
+    cxx_lib.encode_move.argtypes = [c_void_p, c_int]
+    cxx_lib.generate_children_batch.argtypes = [c_void_p, c_double, c_void_p, c_void_p, c_void_p, c_int, c_void_p,
+                                                c_int]
+
+# Packed like the C move struct, to receive the moves of generate_children_batch.
+move_dtype = np.dtype([
+    ('tile', np.uint8),
+    ('next_to', np.uint8),
+    ('direction', np.uint8),
+    ('previous_location', np.int32),
+    ('location', np.int32),
+])
+
+
+# The move struct of the C++ engine has its natural alignment.
+cxx_move_dtype = np.dtype([
+    ('tile', np.uint8),
+    ('next_to', np.uint8),
+    ('direction', np.uint8),
+    ('previous_location', np.int32),
+    ('location', np.int32),
+], align=True)
 
 
 class HiveNode(GameNode):
     encoding = "absolute"
 
-    def __init__(self, parent, node: POINTER(Node)):
+    # Reused buffers for generate_children_batch, the results are copied out per expansion.
+    _moves = np.empty(MAX_CHILDREN, dtype=move_dtype)
+    _encodings = np.empty(MAX_CHILDREN, dtype=np.int32)
+
+    def __init__(self, parent, node: POINTER(Node), owned=True, move=None, encoding=None):
+        """
+        Wraps a C node. Owned nodes are freed with this object, the others are children which are owned by the C node
+        of their parent, they only get a handle together with the move and encoding of their batch.
+        """
         super().__init__(parent)
+        self.n_players = 2
         self.children = []
 
-        self.cnode = lib.default_init()
-        lib.node_copy(self.cnode, node)
+        self.cnode = node
+        self.owned = owned
+        self.move = move
+        self._encoding = encoding
 
+    @property
     def turn(self):
         return self.cnode.contents.board.contents.turn
 
@@ -275,40 +355,152 @@ class HiveNode(GameNode):
         return self.cnode.contents.board.contents.to_np(perspective)
 
     def encode(self):
+        if self._encoding is not None:
+            return self._encoding
+
         # We have no move to get to an initial state.
         if self.turn == 0:
             return None
 
-        move: Move = self.cnode.contents.move
-        tile = move.tile
-        my_idx = lib.to_tile_index(tile & ~COLOR_MASK) - 1  # Range 0:11  (only my tiles (-1 because cannot be empty))
-
-        if HiveNode.encoding == "absolute":
-            location = move.location
-            return my_idx * 26 * 26 + location
-        elif HiveNode.encoding == "relative":
-            next_to = move.next_to
-            direction = move.direction
+        encoding = ENCODING_RELATIVE if HiveNode.encoding == "relative" else ENCODING_ABSOLUTE
+        return lib.encode_move(byref(self.cnode.contents.move), encoding)
 
-            # Returns number of the tile in this order; A3 G3 B2 S2 Q1 -> max idx = 11*2 (W + B)
-            tile_idx = lib.to_tile_index(next_to)  # Range 0:23  (all tiles + empty)
+    def expand(self):
+        self.get_children()
 
-            return (my_idx * 23 + tile_idx) * 7 + direction
-
-    def _generate_children(self):
+    def get_children(self):
         """
-        Generates the moves for the current root node
+        Generates the children of this node with their moves and encodings in a single call to the library, the
+         children only hold a handle to their C node.
 
         :return:
         """
-        res = lib.generate_children(self.cnode, ctypes.c_double(1e64), 0)
-        if res != 0:
-            print(f"Error: generate_children returned {res}, exiting.")
+        if len(self.children) != 0:
+            return self.children
+
+        if self.finished() != GameState.UNDETERMINED:
+            return []
+
+        # The handles of the children point into this array, so it is not reused.
+        handles = (POINTER(Node) * MAX_CHILDREN)()
+        encoding = ENCODING_RELATIVE if HiveNode.encoding == "relative" else ENCODING_ABSOLUTE
+        n = lib.generate_children_batch(self.cnode, ctypes.c_double(1e64), handles,
+                                        HiveNode._moves.ctypes.data_as(c_void_p),
+                                        HiveNode._encodings.ctypes.data_as(c_void_p), encoding, None, MAX_CHILDREN)
+        if n < 0:
+            print(f"Error: generate_children returned {-n}, exiting.")
             exit(1)
 
+        moves = HiveNode._moves[:n].copy()
+        encodings = HiveNode._encodings[:n].tolist()
+        for i in range(n):
+            self.children.append(HiveNode(self, handles[i], owned=False, move=moves[i],
+                                          encoding=None if encodings[i] == -1 else encodings[i]))
+        return self.children
+
+    def release_children(self, keep=None):
+        """
+        Frees the C children of this node except keep, which becomes owned by its Python node.
+        The handles of the other children (and their children) are invalidated.
+        """
+        if keep is not None:
+            lib.list_remove(pointer(keep.cnode.contents.node))
+            keep.owned = True
+
+        for child in self.children:
+            if child is not keep:
+                child._invalidate()
+        self.children = []
+        lib.node_free_children(self.cnode)
+
+    def _invalidate(self):
+        for child in self.children:
+            child._invalidate()
+        self.children = []
+        self.cnode = None
+
+    def finished(self) -> GameState:
+        result = lib.finished_board(self.cnode.contents.board)
+        return GameState(result)
+
+    def print(self):
+        lib.print_board(self.cnode.contents.board)
+
+    def print_move(self):
+        lib.print_move(self.cnode)
+
+    def pack(self) -> PackedPosition:
+        packed = PackedPosition()
+        lib.board_pack(self.cnode.contents.board, byref(packed))
+        return packed
+
+    def __deepcopy__(self, memo):
+        cls = self.__class__
+        gnode = cls.__new__(cls)
+        memo[id(self)] = gnode
+        GameNode.__init__(gnode, None)
+        gnode.n_players = 2
+        gnode.cnode = lib.default_init()
+        lib.node_copy(gnode.cnode, self.cnode)
+        gnode.owned = True
+        gnode.move, gnode._encoding = self.move, self._encoding
+        return gnode
+
+    def __del__(self):
+        if self.owned and self.cnode is not None:
+            lib.node_free(self.cnode)
+
+
+class CxxHiveNode(GameNode):
+    """
+    A node of the C++ engine core, with the same interface as HiveNode. The C++ node is an opaque handle.
+    """
+
+    # Reused buffers for generate_children_batch, the results are copied out per expansion.
+    _moves = np.empty(MAX_CHILDREN, dtype=cxx_move_dtype)
+    _encodings = np.empty(MAX_CHILDREN, dtype=np.int32)
+
+    def __init__(self, parent, node: c_void_p, owned=True, move=None, encoding=None):
+        super().__init__(parent)
+        self.n_players = 2
+        self.children = []
+
+        self.cnode = node
+        self.owned = owned
+        self.move = move
+        self._encoding = encoding
+
+    @property
+    def turn(self):
+        return cxx_lib.node_turn(self.cnode)
+
+    def to_np(self, perspective: Perspectives):
+        player = 0 if perspective == Perspectives.PLAYER1 else 1
+
+        planes = np.empty((N_PLANES, BOARD_SIZE, BOARD_SIZE), dtype=np.uint8)
+        cxx_lib.node_planes(self.cnode, player, planes.ctypes.data_as(c_void_p))
+        return planes
+
+    def encode(self):
+        if self._encoding is not None:
+            return self._encoding
+
+        # We have no move to get to an initial state.
+        if self.turn == 0:
+            return None
+
+        move = np.empty(1, dtype=cxx_move_dtype)
+        cxx_lib.node_get_move(self.cnode, move.ctypes.data_as(c_void_p))
+        encoding = ENCODING_RELATIVE if HiveNode.encoding == "relative" else ENCODING_ABSOLUTE
+        return cxx_lib.encode_move(move.ctypes.data_as(c_void_p), encoding)
+
+    def expand(self):
+        self.get_children()
+
     def get_children(self):
         """
-        A generator for all children of this node.
+        Generates the children of this node with their moves and encodings in a single call to the library, the
+         children only hold a handle to their C++ node.
 
         :return:
         """
@@ -318,42 +510,78 @@ class HiveNode(GameNode):
         if self.finished() != GameState.UNDETERMINED:
             return []
 
-        if self.cnode.contents.board.contents.move_location_tracker == 0:
-            self._generate_children()
+        handles = (c_void_p * MAX_CHILDREN)()
+        encoding = ENCODING_RELATIVE if HiveNode.encoding == "relative" else ENCODING_ABSOLUTE
+        n = cxx_lib.generate_children_batch(self.cnode, ctypes.c_double(1e64), handles,
+                                            CxxHiveNode._moves.ctypes.data_as(c_void_p),
+                                            CxxHiveNode._encodings.ctypes.data_as(c_void_p), encoding, None,
+                                            MAX_CHILDREN)
+        if n < 0:
+            print(f"Error: generate_children returned {-n}, exiting.")
+            exit(1)
 
-        head = self.cnode.contents.children.next
+        moves = CxxHiveNode._moves[:n].copy()
+        encodings = CxxHiveNode._encodings[:n].tolist()
+        for i in range(n):
+            self.children.append(CxxHiveNode(self, c_void_p(handles[i]), owned=False, move=moves[i],
+                                             encoding=None if encodings[i] == -1 else encodings[i]))
+        return self.children
 
-        while ctypes.addressof(head.contents) != ctypes.addressof(self.cnode.contents.children.head):
-            # Get struct offset
-            child = lib.list_get_node(head)
+    def release_children(self, keep=None):
+        """
+        Frees the C++ children of this node except keep, which gets a node of its own owned by its Python node.
+        The handles of the other children (and their children) are invalidated.
+        """
+        for child in self.children:
+            if child is not keep:
+                child._invalidate()
+        self.children = []
 
-            self.children.append(HiveNode(self, child))
+        if keep is not None:
+            keep.cnode = c_void_p(cxx_lib.node_take_child(self.cnode, keep.cnode))
+            keep.owned = True
+            # The children of keep moved along with it, their handles are found again when they are generated.
+            keep._invalidate_children()
+        else:
+            cxx_lib.node_free_children(self.cnode)
 
-            head = head.contents.next
+    def _invalidate_children(self):
+        for child in self.children:
+            child._invalidate()
+        self.children = []
 
-        # After generating python nodes, delete the old ones
-        lib.node_free_children(self.cnode)
-        return self.children
+    def _invalidate(self):
+        self._invalidate_children()
+        self.cnode = None
 
     def finished(self) -> GameState:
-        result = lib.finished_board(self.cnode.contents.board)
-        return GameState(result)
+        return GameState(cxx_lib.finished_board(self.cnode))
 
     def print(self):
-        lib.print_board(self.cnode.contents.board)
+        cxx_lib.print_board(self.cnode)
 
     def print_move(self):
-        lib.print_move(self.cnode)
+        print(self.move)
+
+    def pack(self) -> PackedPosition:
+        packed = PackedPosition()
+        cxx_lib.node_pack(self.cnode, byref(packed))
+        return packed
 
     def __deepcopy__(self, memo):
         cls = self.__class__
         gnode = cls.__new__(cls)
         memo[id(self)] = gnode
-        lib.node_copy(gnode.cnode, self.cnode)
+        GameNode.__init__(gnode, None)
+        gnode.n_players = 2
+        gnode.cnode = c_void_p(cxx_lib.node_copy(self.cnode))
+        gnode.owned = True
+        gnode.move, gnode._encoding = self.move, self._encoding
         return gnode
 
     def __del__(self):
-        lib.node_free(self.cnode)
+        if self.owned and self.cnode is not None:
+            cxx_lib.node_free(self.cnode)
 
 
 class Hive(Game):
@@ -364,14 +592,20 @@ class Hive(Game):
     input_space = 26 * 26 * 2
     action_space = encodings["absolute"]
 
+    # The engine generating the nodes, "c" for libhive.so or "cxx" for the C++ engine core in libcxx_hive.so.
+    core = "c"
+
     def __init__(self):
         super().__init__()
 
         self.history: list[HiveNode] = []
 
-        cnode = lib.game_init()
-        self.node = HiveNode(None, cnode)
-        lib.node_free(cnode)
+        if self.core == "cxx":
+            if cxx_lib is None:
+                raise RuntimeError(f"The C++ engine core is not built, '{_cxx_path}' does not exist.")
+            self.node = CxxHiveNode(None, c_void_p(cxx_lib.game_init()))
+        else:
+            self.node = HiveNode(None, lib.game_init())
 
         self.history.append(self.node)
 
@@ -400,9 +634,8 @@ class Hive(Game):
     def select_child(self, child: HiveNode):
         self.history.append(child)
 
-        # Remove C-references to memory
-        lib.node_free_children(self.node.cnode)
-        self.node.children = []
+        # The child is taken from the C children of the node, the others are freed.
+        self.node.release_children(keep=child)
 
         self.node = child
         self.node.parent = None
@@ -427,10 +660,31 @@ class Hive(Game):
             self.select_child(random.sample(children, 1)[0])
             return
         elif algorithm == "mm":
-            child = lib.minimax(self.node.cnode, pointer(config))
+            search = lib.minimax
         elif algorithm == "mcts":
-            child = lib.mcts(self.node.cnode, pointer(config))
+            search = lib.mcts
         else:
             raise ValueError("Unknown algorithm type.")
 
-        self.select_child(child.contents)
+        if isinstance(self.node, CxxHiveNode):
+            self.select_child(self._search_cxx(search, config))
+            return
+
+        # The returned node is one of the C children of the node.
+        child = search(self.node.cnode, pointer(config))
+        self.select_child(HiveNode(self.node, child, owned=False))
+
+    def _search_cxx(self, search, config: PlayerArguments) -> CxxHiveNode:
+        """
+        The searches are in the C engine, so they search the packed position of the C++ node, and the C++ child with
+         the same packed position as the chosen child is returned.
+        """
+        root = HiveNode(None, lib.game_init())
+        lib.board_unpack(root.cnode.contents.board, byref(self.node.pack()))
+
+        chosen = PackedPosition()
+        lib.board_pack(search(root.cnode, pointer(config)).contents.board, byref(chosen))
+        for child in self.node.get_children():
+            if child.pack().bits[:] == chosen.bits[:]:
+                return child
+        raise RuntimeError("The move of the search is not a move of the C++ engine.")
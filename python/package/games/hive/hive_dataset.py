@@ -1,6 +1,9 @@
+import numpy as np
 import torch
 from torch.utils.data import Dataset
 
+from games.hive.hive import N_PLANES, N_SYMMETRIES, BOARD_SIZE, Hive, lib
+
 
 class HiveDataset(Dataset):
     def __init__(self, boards: torch.Tensor, expected: torch.Tensor, outcomes: torch.Tensor, cuda=False):
@@ -30,3 +33,42 @@ class HiveDataset(Dataset):
 
         out = HiveDataset(new_boards, new_expected, new_outcomes, cuda=self.cuda)
         return out
+
+
+class SelfPlayDataset(Dataset):
+    """
+    The records written by the native self-play generator. The file is memory-mapped by the library, and a position
+     is only expanded to its planes and policy when it is read, so the boards are never all held in memory.
+    With augment set every record appears once per rotation and reflection of the board.
+    """
+
+    def __init__(self, filename: str, augment: bool = False):
+        self.filename = filename
+        self.handle = lib.dataset_open(filename.encode())
+        if self.handle is None:
+            raise ValueError(f"'{filename}' does not hold self-play records of this board layout.")
+        self.n_records = lib.dataset_size(self.handle)
+        self.n_symmetries = N_SYMMETRIES if augment else 1
+        self.length = self.n_records * self.n_symmetries
+
+    @property
+    def outcomes(self) -> torch.Tensor:
+        outcomes = np.empty(self.n_records, dtype=np.float32)
+        lib.dataset_outcomes(self.handle, outcomes.ctypes.data)
+        return torch.from_numpy(outcomes).repeat_interleave(self.n_symmetries).view(-1, 1)
+
+    def __len__(self):
+        return self.length
+
+    def __getitem__(self, idx):
+        if not 0 <= idx < self.length:
+            raise IndexError(idx)
+        record, symmetry = divmod(idx, self.n_symmetries)
+        planes = np.empty((N_PLANES, BOARD_SIZE, BOARD_SIZE), dtype=np.uint8)
+        policy = np.empty(Hive.action_space, dtype=np.float32)
+        outcome = lib.dataset_get(self.handle, record, symmetry, planes.ctypes.data, policy.ctypes.data)
+        return torch.from_numpy(planes).float(), torch.from_numpy(policy), torch.Tensor([outcome])
+
+    def __del__(self):
+        if getattr(self, "handle", None) is not None:
+            lib.dataset_close(self.handle)
@@ -29,6 +29,11 @@ def main():
                     if args.game.lower() in s.__name__.lower()][0]
     del args.game
 
+    # Games with more than one engine generate their nodes with the chosen one.
+    if hasattr(game_type, "core"):
+        game_type.core = args.core
+    del args.core
+
     # Optimize backends
     torch.backends.cudnn.benchmark = True
     # torch.set_float32_matmul_precision('medium')
@@ -0,0 +1,82 @@
+import ctypes
+import random
+import unittest
+
+import numpy as np
+
+from games.hive.hive import lib, Hive, HiveNode, Node, MAX_CHILDREN, N_PLANES, BOARD_SIZE, ENCODING_ABSOLUTE, \
+    move_dtype
+from games.utils import GameState
+
+
+class HiveBatchTestCase(unittest.TestCase):
+    """
+    The children of generate_children_batch should be the ones of walking the C children list one by one.
+    """
+
+    def positions(self, n_games=3, n_turns=30):
+        random.seed(0)
+        for _ in range(n_games):
+            game = Hive()
+            for _ in range(n_turns):
+                if game.finished() != GameState.UNDETERMINED:
+                    break
+                yield game.node
+                game.select_child(random.choice(game.node.get_children()))
+
+    def test_batch_matches_list(self):
+        for node in self.positions():
+            # A copy of the node, its children are generated by the batch call.
+            cnode = lib.default_init()
+            lib.node_copy(cnode, node.cnode)
+
+            handles = (ctypes.POINTER(Node) * MAX_CHILDREN)()
+            moves = np.empty(MAX_CHILDREN, dtype=move_dtype)
+            encodings = np.empty(MAX_CHILDREN, dtype=np.int32)
+            planes = np.empty((MAX_CHILDREN, N_PLANES, BOARD_SIZE, BOARD_SIZE), dtype=np.uint8)
+            n = lib.generate_children_batch(cnode, ctypes.c_double(1e64), handles,
+                                            moves.ctypes.data_as(ctypes.c_void_p),
+                                            encodings.ctypes.data_as(ctypes.c_void_p), ENCODING_ABSOLUTE,
+                                            planes.ctypes.data_as(ctypes.c_void_p), MAX_CHILDREN)
+            self.assertGreater(n, 0)
+
+            # The old path, the children list walked with list_get_node and every child converted on its own.
+            head = cnode.contents.children.next
+            i = 0
+            while ctypes.addressof(head.contents) != ctypes.addressof(cnode.contents.children.head):
+                child = lib.list_get_node(head)
+                board = child.contents.board.contents
+
+                self.assertEqual(ctypes.addressof(child.contents), ctypes.addressof(handles[i].contents))
+                self.assertEqual(bytes(child.contents.move), moves[i].tobytes())
+                self.assertEqual(lib.encode_move(ctypes.byref(child.contents.move), ENCODING_ABSOLUTE),
+                                 encodings[i])
+                self.assertTrue(np.array_equal(board.to_np(board.turn % 2), planes[i]))
+
+                head = head.contents.next
+                i += 1
+            self.assertEqual(i, n)
+
+            lib.node_free(cnode)
+
+    def test_children_match_list(self):
+        for node in self.positions():
+            children = node.get_children()
+
+            cnode = lib.default_init()
+            lib.node_copy(cnode, node.cnode)
+            lib.generate_children(cnode, ctypes.c_double(1e64), 0)
+
+            head = cnode.contents.children.next
+            for child in children:
+                other = HiveNode(None, lib.list_get_node(head), owned=False)
+                self.assertEqual(child.encode(), other.encode())
+                self.assertTrue(np.array_equal(child.to_np(child.to_play), other.to_np(other.to_play)))
+                head = head.contents.next
+            self.assertEqual(ctypes.addressof(head.contents), ctypes.addressof(cnode.contents.children.head))
+
+            lib.node_free(cnode)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,77 @@
+import os
+import random
+import struct
+import tempfile
+import unittest
+
+import numpy as np
+
+from games.hive.hive import lib, Hive, HiveNode, N_PLANES, BOARD_SIZE
+from games.hive.hive_dataset import SelfPlayDataset
+from games.utils import GameState
+
+
+class SelfPlayDatasetTestCase(unittest.TestCase):
+    """
+    Reads record files in the format of the native self-play generator (cpp/ml/self_play.h).
+    """
+
+    @staticmethod
+    def record(node: HiveNode, outcome: int, policy: list[tuple[int, float]]) -> bytes:
+        data = bytes(node.pack()) + struct.pack("<bH", outcome, len(policy))
+        for encoding, probability in policy:
+            data += struct.pack("<Hf", encoding, probability)
+        return data
+
+    def write(self, records: list[bytes], truncate: int = 0) -> str:
+        file, path = tempfile.mkstemp(suffix=".data")
+        with os.fdopen(file, "wb") as f:
+            f.write(struct.pack("<8sIII", b"HIVESP3", N_PLANES, BOARD_SIZE, Hive.action_space))
+            data = b"".join(records)
+            f.write(data[:len(data) - truncate])
+        self.addCleanup(os.remove, path)
+        return path
+
+    def positions(self, n):
+        random.seed(0)
+        game = Hive()
+        nodes = []
+        while len(nodes) < n and game.finished() == GameState.UNDETERMINED:
+            nodes.append(game.node)
+            game.select_child(random.choice(game.node.get_children()))
+        return nodes
+
+    def test_truncated_record(self):
+        nodes = self.positions(4)
+        outcomes = [1, -1, 0, 1]
+        policies = [[(i, 1.)] for i in range(3)] + [[(3, .5), (4, .5)]]
+        records = [self.record(node, outcome, policy) for node, outcome, policy in zip(nodes, outcomes, policies)]
+
+        # The generator stopped halfway through the policy of the last record, so only the first three are read.
+        dataset = SelfPlayDataset(self.write(records, truncate=3))
+        self.assertEqual(len(dataset), 3)
+        self.assertEqual(dataset.outcomes.flatten().tolist(), outcomes[:3])
+
+        for i, node in enumerate(nodes[:3]):
+            planes, policy, outcome = dataset[i]
+            self.assertEqual(outcome.item(), outcomes[i])
+            self.assertEqual(np.flatnonzero(np.asarray(policy)).tolist(), [i])
+
+            # The planes are those of the position with the hive centered, as unpacking the position puts it.
+            unpacked = HiveNode(None, lib.game_init())
+            lib.board_unpack(unpacked.cnode.contents.board, node.pack())
+            self.assertTrue(np.array_equal(np.asarray(planes), unpacked.to_np(unpacked.to_play)))
+
+        with self.assertRaises(IndexError):
+            _ = dataset[3]
+
+    def test_truncated_header_of_record(self):
+        records = [self.record(node, 0, [(0, 1.)]) for node in self.positions(2)]
+
+        # Only part of the fixed size position of the last record was written.
+        dataset = SelfPlayDataset(self.write(records, truncate=len(records[-1]) - 5))
+        self.assertEqual(len(dataset), 1)
+
+
+if __name__ == '__main__':
+    unittest.main()
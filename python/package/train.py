@@ -2,6 +2,7 @@ import copy
 import logging
 import os
 import pickle
+import subprocess
 from collections import defaultdict
 from datetime import datetime
 from typing import Type
@@ -9,12 +10,12 @@ from typing import Type
 import pytorch_lightning
 import torch
 from pytorch_lightning import Trainer
-from torch.utils.data import DataLoader
+from torch.utils.data import DataLoader, ConcatDataset
 from tqdm import tqdm
 
 from games.Game import Game, GameNode
-from games.hive.hive import GameState
-from games.hive.hive_dataset import HiveDataset
+from games.hive.hive import GameState, N_PLANES, BOARD_SIZE
+from games.hive.hive_dataset import HiveDataset, SelfPlayDataset
 from games.utils import Perspectives
 from mpi_packet import MPIPacketState, MPIPacket
 from simulator import Simulator
@@ -22,7 +23,8 @@ from simulator import Simulator
 
 class School:
     def __init__(self, game: Type[Game], network: Type[pytorch_lightning.LightningModule], n_sims=100,
-                 n_data_reuse=1, model_dir="model", data_dir="data", device="cuda:0", comm=None, **kwargs):
+                 n_data_reuse=1, model_dir="model", data_dir="data", device="cuda:0", comm=None, mcts_iterations=40,
+                 self_play_binary=None, augment_symmetries=False, **kwargs):
         self.logger = logging.getLogger("Hive")
         self.network_type = network
 
@@ -45,12 +47,36 @@ class School:
         self.stable_network = copy.deepcopy(self.updating_network)
 
         self.simulations = n_sims
+        self.mcts_iterations = mcts_iterations
+        # The native self-play generator of the C++ engine, replacing the MPI workers if set.
+        self.self_play_binary = self_play_binary
+        # Train on all 12 symmetries of every native record.
+        self.augment_symmetries = augment_symmetries
 
         self.n_old_data = n_data_reuse
         self.old_data_storage = []
         self.comm = comm
         self.logger.info("Done initializing trainer.")
 
+    def generate_data_native(self, filename: str):
+        """
+        Plays the games with the native self-play generator, which writes the training records to disk directly.
+        The networks are handed over as TorchScript modules.
+
+        :param filename: the file to write the records to
+        """
+        example = torch.zeros(1, N_PLANES, BOARD_SIZE, BOARD_SIZE)
+        player_path = os.path.join(self.model_dir, "self_play_player.pt")
+        opponent_path = os.path.join(self.model_dir, "self_play_opponent.pt")
+        self.updating_network.to("cpu").to_torchscript(player_path, method="trace", example_inputs=example)
+        self.stable_network.to("cpu").to_torchscript(opponent_path, method="trace", example_inputs=example)
+
+        self.logger.info(f"Simulating {self.simulations} games with {self.self_play_binary}.")
+        start = datetime.now()
+        subprocess.run([self.self_play_binary, "-m", player_path, "-o", opponent_path, "-n", str(self.simulations),
+                        "-i", str(self.mcts_iterations), "-f", filename], check=True)
+        self.logger.debug(f"Spent {datetime.now() - start} to simulate {self.simulations} games.")
+
     def generate_data(self):
         assert self.comm is not None
         # If you are pretraining, play against the fixed opponent instead.
@@ -168,62 +194,70 @@ class School:
         network_iter = 0
 
         for u in range(updates):
-            if self.data_dir is not None:
-                filename = os.path.join(self.data_dir, f"example{u}.data")
-            else:
-                filename = None
-
-            if filename is None or not os.path.isfile(filename):
+            if self.self_play_binary is not None:
                 ##############################################################################
-                # Generate data with current two models
+                # Generate records natively, the file on disk is the dataset.
                 ##############################################################################
-                data = self.generate_data()
-                # Combine the results of each thread into single packet arrays.
-                tensors = []
-                policy_vectors = []
-                outcomes = []
-
-                for i, tensor, policy_vector, result, perspective in data:
-                    tensors += tensor
-                    policy_vectors += policy_vector
-                    outcomes += result
-
-                if filename is not None:
-                    torch.save(list(zip(tensors, policy_vectors, outcomes)), filename)
+                directory = self.data_dir if self.data_dir is not None else self.model_dir
+                filename = os.path.join(directory, f"example{u}.records")
+                if not os.path.isfile(filename):
+                    self.generate_data_native(filename)
+                dataset = SelfPlayDataset(filename, augment=self.augment_symmetries)
+                outcomes = dataset.outcomes
             else:
-                ##############################################################################
-                # Load existing data from disk.
-                ##############################################################################
-                tensors, policy_vectors, outcomes = zip(*torch.load(filename))
-
-            # Convert to tensors
-            if len(tensors) > 0:
-                tensors = torch.stack(tensors)
-                policy_vectors = torch.stack(policy_vectors)
-                outcomes = torch.stack(outcomes)
+                if self.data_dir is not None:
+                    filename = os.path.join(self.data_dir, f"example{u}.data")
+                else:
+                    filename = None
+
+                if filename is None or not os.path.isfile(filename):
+                    ##############################################################################
+                    # Generate data with current two models
+                    ##############################################################################
+                    data = self.generate_data()
+                    # Combine the results of each thread into single packet arrays.
+                    tensors = []
+                    policy_vectors = []
+                    outcomes = []
+
+                    for i, tensor, policy_vector, result, perspective in data:
+                        tensors += tensor
+                        policy_vectors += policy_vector
+                        outcomes += result
+
+                    if filename is not None:
+                        torch.save(list(zip(tensors, policy_vectors, outcomes)), filename)
+                else:
+                    ##############################################################################
+                    # Load existing data from disk.
+                    ##############################################################################
+                    tensors, policy_vectors, outcomes = zip(*torch.load(filename))
+
+                # Convert to tensors
+                if len(tensors) > 0:
+                    tensors = torch.stack(tensors)
+                    policy_vectors = torch.stack(policy_vectors)
+                    outcomes = torch.stack(outcomes)
+                dataset = HiveDataset(tensors, policy_vectors, outcomes, cuda=False)
 
             out_res = defaultdict(int)
             for outcome in outcomes:
                 out_res[int(outcome.item())] += 1
             self.logger.info(f"Training winrate: {out_res}")
-            self.logger.info(f"{len(tensors)} boards added to dataset.")
-            if len(tensors) == 0:
+            self.logger.info(f"{len(dataset)} boards added to dataset.")
+            if len(dataset) == 0:
                 self.logger.warning("No tensors added, re-running simulation to get more data.")
                 continue
 
             ##############################################################################
             # Aggregate data into Dataset
             ##############################################################################
-            dataset = HiveDataset(tensors, policy_vectors, outcomes, cuda=False)
-
-            # Store older data for N updates
+            # Store older data for N updates, they are concatenated without copying.
             self.old_data_storage.append(dataset)
             if len(self.old_data_storage) > self.n_old_data:
                 self.old_data_storage = self.old_data_storage[1:]
 
-            aggregated_dataset = copy.deepcopy(self.old_data_storage[0])
-            for old_data in self.old_data_storage[1:]:
-                aggregated_dataset += old_data
+            aggregated_dataset = ConcatDataset(self.old_data_storage)
 
             self.logger.info(f"Training on {len(aggregated_dataset)} boards.")
             dataloader = DataLoader(aggregated_dataset, batch_size=batch_size, shuffle=True, num_workers=0)
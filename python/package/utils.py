@@ -51,5 +51,13 @@ def setup_parser():
     parser.add_argument("--device", type=str, default="cuda",
                         help="Device to run on, when specifying cuda, all workers will be split across the available "
                              "cuda devices evenly.")
+    parser.add_argument("--self_play_binary", type=str, default=None,
+                        help="The native self-play generator (cxx_self_play) to simulate the games with, instead of "
+                             "the MPI workers.")
+    parser.add_argument("--augment_symmetries", action="store_true",
+                        help="Train on every rotation and reflection of the native self-play records.")
+    parser.add_argument("--core", type=str, choices=["c", "cxx"], default="c",
+                        help="The engine generating the moves of Hive, the C engine (libhive.so) or the C++ engine "
+                             "core (libcxx_hive.so).")
 
     return parser